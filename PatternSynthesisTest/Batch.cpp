@@ -0,0 +1,508 @@
+#include "Batch.h"
+#include "SpringKernel.h"
+
+#include <SFML\Graphics.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+
+// Same scale as main.cpp: 1 Meter = 30 pixels
+static const float SCALE = 30.f;
+
+// Sets a single option by key, shared by the command line and config file parsers
+static bool setBatchOption(BatchJob& job, const std::string& key, const std::string& value)
+{
+	try {
+		if (key == "pattern") {
+			if (!parsePatternType(value, job.pattern.type)) {
+				std::cout << "Unknown pattern type: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (key == "rasf") {
+			if (!parseRASFType(value, job.pattern.rasfType)) {
+				std::cout << "Unknown RASF type: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (key == "size") job.pattern.size = std::stoul(value);
+		else if (key == "value") job.pattern.rasfValue = std::stof(value);
+		else if (key == "relax") job.pattern.relaxIterations = std::stoul(value);
+		else if (key == "min-distance") job.pattern.minDistance = std::stof(value);
+		else if (key == "tiles") job.pattern.voronoiTiles = std::stoul(value);
+		else if (key == "seed") job.seed = std::stoul(value);
+		else if (key == "steps") job.maxSteps = std::stoul(value);
+		else if (key == "timestep") job.timeStep = std::stof(value);
+		else if (key == "settle-speed") job.settle.maxSpeed = std::stof(value);
+		else if (key == "settle-energy") job.settle.kineticEnergy = std::stof(value);
+		else if (key == "settle-length") job.settle.lengthResidual = std::stof(value);
+		else if (key == "settle-angle") job.settle.angleResidual = std::stof(value) * DEGTORAD;
+		else if (key == "settle-interval") job.settle.checkInterval = std::stoul(value);
+		else if (key == "sleep") job.sleep = std::stoul(value) != 0;
+		else if (key == "adaptive") job.subdivision.enabled = std::stoul(value) != 0;
+		else if (key == "adaptive-bend") job.subdivision.maxBend = std::stof(value) * DEGTORAD;
+		else if (key == "adaptive-merge") job.subdivision.maxMerge = std::stoul(value);
+		else if (key == "spring-solver") {
+			if (value == "forces") job.springSolver = SPRING_SOLVER_FORCES;
+			else if (value == "joints") job.springSolver = SPRING_SOLVER_JOINTS;
+			else if (value == "network") job.springSolver = SPRING_SOLVER_NETWORK;
+			else {
+				std::cout << "Unknown spring solver: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (key == "spring-stiffness") job.springStiffness = std::stof(value);
+		else if (key == "step-mode") {
+			if (value == "iterations") job.stepping.mode = STEP_MODE_ITERATIONS;
+			else if (value == "substep") job.stepping.mode = STEP_MODE_SUBSTEP;
+			else {
+				std::cout << "Unknown step mode: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (key == "velocity-iterations") job.stepping.velocityIterations = std::stoi(value);
+		else if (key == "position-iterations") job.stepping.positionIterations = std::stoi(value);
+		else if (key == "velocity-tolerance") job.stepping.velocityTolerance = std::stof(value);
+		else if (key == "network-iterations") job.stepping.networkIterations = std::stoi(value);
+		else if (key == "substeps") job.stepping.substeps = std::stoul(value);
+		else if (key == "substep-iterations") job.stepping.substepIterations = std::stoi(value);
+		else if (key == "joint-hertz") job.stepping.jointHertz = std::stof(value);
+		else if (key == "joint-damping") job.stepping.jointDampingRatio = std::stof(value);
+		else if (key == "benchmark") job.benchmark = std::stoul(value) != 0;
+		else if (key == "kernel") {
+			if (value == "batched") job.forceKernel = FORCE_KERNEL_BATCHED;
+			else if (value == "reference") job.forceKernel = FORCE_KERNEL_REFERENCE;
+			else {
+				std::cout << "Unknown force kernel: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (key == "kernel-check") job.kernelCheck = std::stoul(value) != 0;
+		else if (key == "kernel-tolerance") job.kernelTolerance = std::stof(value);
+		else if (key == "threads") job.threads = std::stoul(value);
+		else if (key == "patterns") job.patterns = std::stoul(value);
+		else if (key == "pattern-threads") job.patternThreads = std::stoul(value);
+		else if (key == "stress") job.stress = std::stoul(value) != 0;
+		else if (key == "width") job.width = std::stoul(value);
+		else if (key == "height") job.height = std::stoul(value);
+		else if (key == "output") job.outputPath = value;
+		else if (key == "config") return loadBatchConfig(value, job);
+		else {
+			std::cout << "Unknown option: " << key << std::endl;
+			return false;
+		}
+	}
+	catch (const std::exception&) {
+		std::cout << "Invalid value for " << key << ": " << value << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool parseBatchArgs(int argc, char* argv[], BatchJob& job)
+{
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc) {
+			std::cout << "Expected \"--option value\", got: " << arg << std::endl;
+			return false;
+		}
+		if (!setBatchOption(job, arg.substr(2), argv[++i])) return false;
+	}
+	return true;
+}
+
+bool loadBatchConfig(const std::string& filename, BatchJob& job)
+{
+	std::ifstream file(filename);
+	if (!file) {
+		std::cout << "Could not open config file: " << filename << std::endl;
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		line = line.substr(0, line.find('#'));
+		for (char& c : line) if (c == '=') c = ' ';
+
+		std::istringstream stream(line);
+		std::string key, value;
+		if (!(stream >> key)) continue; // Blank line
+		if (!(stream >> value)) {
+			std::cout << "Missing value for " << key << " in " << filename << std::endl;
+			return false;
+		}
+		if (!setBatchOption(job, key, value)) return false;
+	}
+	return true;
+}
+
+void printBatchUsage()
+{
+	std::cout << "Usage: PatternSynthesis [--option value]..." << std::endl;
+	std::cout << "With no options the interactive window is opened instead." << std::endl;
+	std::cout << "  --pattern       line, box, squiggle, voronoi, tree, random-tree, uniform-voronoi, grid, centroidal-voronoi, poisson-voronoi (or 1-10)" << std::endl;
+	std::cout << "  --size          springs per side, number of points, fractal depth or grid side (depends on pattern)" << std::endl;
+	std::cout << "  --rasf          constant, lerp, average, randomized, sin, pseudorandom, sequential-sin, sequential-sin-lerp (or 1-8)" << std::endl;
+	std::cout << "  --value         RASF value (either a multiplier value, or an angle in degrees)" << std::endl;
+	std::cout << "  --relax         Lloyd relaxation iterations for centroidal-voronoi" << std::endl;
+	std::cout << "  --min-distance  closest two points of poisson-voronoi can be (pixels), 0 to pick it from size" << std::endl;
+	std::cout << "  --tiles         generate Voronoi diagrams as this many tiles per side, one per thread (1 for the whole diagram at once)" << std::endl;
+	std::cout << "  --seed          random seed" << std::endl;
+	std::cout << "  --steps         maximum number of simulation steps" << std::endl;
+	std::cout << "  --timestep      simulation time step in seconds" << std::endl;
+	std::cout << "  --settle-speed  stop early once no body moves faster than this (m/s), 0 to ignore" << std::endl;
+	std::cout << "  --settle-energy stop early once the total kinetic energy is below this (J), 0 to ignore" << std::endl;
+	std::cout << "  --settle-length stop early once no spring is further than this from its rest length (m), 0 to ignore" << std::endl;
+	std::cout << "  --settle-angle  stop early once no spring is further than this from its rest angle (degrees), 0 to ignore" << std::endl;
+	std::cout << "  --settle-interval steps between settle checks" << std::endl;
+	std::cout << "  --sleep         1 to let settled bodies sleep, 0 to keep every body awake (default)" << std::endl;
+	std::cout << "  --adaptive      1 to merge runs of springs that stay straight into longer ones, 0 for evenly spaced springs (default)" << std::endl;
+	std::cout << "  --adaptive-bend most a merged spring may hide of its line's rest angles (degrees)" << std::endl;
+	std::cout << "  --adaptive-merge most springs merged into one" << std::endl;
+	std::cout << "  --spring-solver forces (explicit, default), joints (implicit, allows stiffer springs and a longer --timestep with fewer iterations)" << std::endl;
+	std::cout << "                  or network (position based point masses instead of Box2D bodies, least memory)" << std::endl;
+	std::cout << "  --network-iterations   constraint iterations per step with --spring-solver network" << std::endl;
+	std::cout << "  --spring-stiffness multiplier for every spring's stiffness" << std::endl;
+	std::cout << "  --step-mode     iterations (one step, many solver iterations, default) or substep (several steps, few iterations, soft joints)" << std::endl;
+	std::cout << "  --velocity-iterations  solver velocity iterations per step in iterations mode" << std::endl;
+	std::cout << "  --position-iterations  solver position iterations per step in iterations mode" << std::endl;
+	std::cout << "  --velocity-tolerance   stop velocity iterations once one changes no body's velocity by more than this (m/s), 0 to run them all (default)" << std::endl;
+	std::cout << "  --substeps      sub-steps per step in substep mode, allows a longer --timestep" << std::endl;
+	std::cout << "  --substep-iterations   solver velocity iterations per sub-step" << std::endl;
+	std::cout << "  --joint-hertz   stiffness of the soft joints in substep mode (natural frequency)" << std::endl;
+	std::cout << "  --joint-damping damping ratio of the soft joints in substep mode" << std::endl;
+	std::cout << "  --benchmark     1 to time both step modes on the pattern instead of saving an image" << std::endl;
+	std::cout << "  --kernel        batched (SIMD, default) or reference (exact, one spring at a time)" << std::endl;
+	std::cout << "  --kernel-check  1 to simulate with both kernels and fail if any body ends up further apart than --kernel-tolerance" << std::endl;
+	std::cout << "  --kernel-tolerance     largest body position difference (m) --kernel-check allows, default one pixel (1/30 m)" << std::endl;
+	std::cout << "  --threads       threads for the spring force pass, 0 for one per core (default)" << std::endl;
+	std::cout << "  --patterns      run this many patterns at once with seeds seed, seed + 1, ..., each saved as <output>_<seed>.png" << std::endl;
+	std::cout << "  --pattern-threads      patterns run at once with --patterns, 0 for one per core (default)" << std::endl;
+	std::cout << "  --stress        1 to run the patterns at once and then one at a time, and check they come out identical" << std::endl;
+	std::cout << "  --width         image width in pixels" << std::endl;
+	std::cout << "  --height        image height in pixels" << std::endl;
+	std::cout << "  --output        image file to write" << std::endl;
+	std::cout << "  --config        file with one \"option value\" pair per line" << std::endl;
+}
+
+// Darkens a single pixel by coverage (0 to 1), overlapping lines accumulate like they would when blended
+static void plot(std::vector<float32>& coverage, unsigned int width, unsigned int height, int x, int y, float32 c)
+{
+	if (x < 0 || y < 0 || x >= (int)width || y >= (int)height) return;
+	float32& pixel = coverage[y * width + x];
+	pixel = 1.0f - (1.0f - pixel) * (1.0f - c);
+}
+
+// Xiaolin Wu's anti-aliased line algorithm
+static void drawLine(std::vector<float32>& coverage, unsigned int width, unsigned int height, float32 x0, float32 y0, float32 x1, float32 y1)
+{
+	bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+	if (steep) {
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+	if (x0 > x1) {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+	}
+
+	float32 dx = x1 - x0;
+	float32 gradient = dx == 0.0f ? 1.0f : (y1 - y0) / dx;
+
+	int xStart = (int)std::round(x0);
+	int xEnd = (int)std::round(x1);
+	float32 y = y0 + gradient * (xStart - x0);
+
+	for (int x = xStart; x <= xEnd; x++) {
+		int yFloor = (int)std::floor(y);
+		float32 frac = y - yFloor;
+		if (steep) {
+			plot(coverage, width, height, yFloor, x, 1.0f - frac);
+			plot(coverage, width, height, yFloor + 1, x, frac);
+		}
+		else {
+			plot(coverage, width, height, x, yFloor, 1.0f - frac);
+			plot(coverage, width, height, x, yFloor + 1, frac);
+		}
+		y += gradient;
+	}
+}
+
+void rasterizeEdges(const std::vector<Edge>& edges, unsigned int width, unsigned int height, std::vector<uint8>& pixels)
+{
+	std::vector<float32> coverage(width * height, 0.0f);
+
+	for (const Edge& e : edges) {
+		drawLine(coverage, width, height,
+			(e.a.x * SCALE) + width / 2, (e.a.y * SCALE) + height / 2,
+			(e.b.x * SCALE) + width / 2, (e.b.y * SCALE) + height / 2);
+	}
+
+	pixels.resize(width * height * 4);
+	for (unsigned int i = 0; i < width * height; i++) {
+		uint8 shade = (uint8)(255.0f * (1.0f - coverage[i]) + 0.5f);
+		pixels[i * 4 + 0] = shade;
+		pixels[i * 4 + 1] = shade;
+		pixels[i * 4 + 2] = shade;
+		pixels[i * 4 + 3] = 255;
+	}
+}
+
+// Creates the job's pattern in sWorld, building it with scratch's memory, and steps it until it settles or runs out of steps
+// Returns the time spent stepping in milliseconds
+static float32 simulateJob(const BatchJob& job, const StepSettings& stepping, const ConvergenceCriteria& settle, SpringWorld& sWorld, PatternScratch& scratch, std::ostream& log)
+{
+	sWorld.setForceKernel(job.forceKernel);
+	sWorld.setConvergenceCriteria(settle);
+	sWorld.setSleeping(job.sleep);
+	sWorld.setSubdivision(job.subdivision);
+	sWorld.setStepSettings(stepping);
+	sWorld.setSpringSolver(job.springSolver, job.springStiffness);
+
+	createPattern(&sWorld, job.pattern, job.width, job.height, &scratch, log);
+
+	log << "There are " << sWorld.getBodyCount() << " bodies in the scene." << std::endl;
+
+	b2Timer timer;
+	while (sWorld.getStepCount() < job.maxSteps && !sWorld.hasConverged()) {
+		sWorld.update(job.timeStep);
+	}
+	float32 milliseconds = timer.GetMilliseconds();
+	log << "Simulated " << sWorld.getStepCount() << " steps" << (sWorld.hasConverged() ? ", pattern settled." : ".") << std::endl;
+
+	// A spring network never steps the world
+	const SolverStats& stats = sWorld.getSolverStats();
+	if (stats.worldSteps > 0) {
+		log << "Solver iterations per world step: " << stats.averageVelocityIterations() << " velocity (most " << stats.maxVelocityIterations << "), "
+			<< stats.averagePositionIterations() << " position (most " << stats.maxPositionIterations << ")" << std::endl;
+	}
+	return milliseconds;
+}
+
+// Simulates the job in a world of its own and returns the final springs
+// pool may be nullptr to run everything on the calling thread
+static std::vector<Edge> simulatePattern(const BatchJob& job, ThreadPool* pool, PatternScratch& scratch, std::ostream& log)
+{
+	// Create world, without gravity
+	b2World world(b2Vec2(0.0f, 0.0f));
+	SpringWorld sWorld(&world, job.seed);
+	sWorld.setThreadPool(pool);
+
+	simulateJob(job, job.stepping, job.settle, sWorld, scratch, log);
+	return sWorld.getSpringEdges();
+}
+
+static bool saveImage(const BatchJob& job, const std::vector<Edge>& edges, std::ostream& log)
+{
+	std::vector<uint8> pixels;
+	rasterizeEdges(edges, job.width, job.height, pixels);
+
+	sf::Image image;
+	image.create(job.width, job.height, pixels.data());
+	if (!image.saveToFile(job.outputPath)) {
+		log << "Could not save image to " << job.outputPath << std::endl;
+		return false;
+	}
+	log << "Saved " << job.outputPath << std::endl;
+	return true;
+}
+
+bool runBatchJob(const BatchJob& job)
+{
+	ThreadPool threadPool(job.threads);
+	PatternScratch scratch;
+	return saveImage(job, simulatePattern(job, &threadPool, scratch, std::cout), std::cout);
+}
+
+std::vector<BatchJob> expandBatchJobs(const BatchJob& job)
+{
+	std::string path = job.outputPath;
+	std::string extension;
+	size_t dot = path.find_last_of('.');
+	if (dot != std::string::npos && path.find_first_of("/\\", dot) == std::string::npos) {
+		extension = path.substr(dot);
+		path = path.substr(0, dot);
+	}
+
+	std::vector<BatchJob> jobs(std::max(job.patterns, 1u), job);
+	for (unsigned int i = 0; i < jobs.size(); i++) {
+		jobs[i].seed = job.seed + i;
+		jobs[i].outputPath = path + "_" + std::to_string(jobs[i].seed) + extension;
+	}
+	return jobs;
+}
+
+// Runs every job on the pool, one pattern per thread, and returns their springs in job order
+// A job's log is printed in one piece once it finishes, so the output of concurrent jobs does not interleave
+static std::vector<std::vector<Edge>> simulatePatterns(const std::vector<BatchJob>& jobs, ThreadPool& pool, float32& milliseconds)
+{
+	std::vector<std::vector<Edge>> edges(jobs.size());
+	std::mutex logMutex;
+
+	// Each thread builds every pattern it runs in the same memory
+	std::vector<std::unique_ptr<PatternScratch>> scratch;
+	for (unsigned int i = 0; i < pool.getThreadCount(); i++) scratch.push_back(std::unique_ptr<PatternScratch>(new PatternScratch()));
+
+	b2Timer timer;
+	pool.parallelFor((unsigned int)jobs.size(), [&](unsigned int i, unsigned int threadIndex) {
+		// The pool is busy running patterns, so each pattern runs on its own thread (job.threads is ignored)
+		std::ostringstream log;
+		log << "Pattern " << i + 1 << " of " << jobs.size() << ", seed " << jobs[i].seed << ":" << std::endl;
+		edges[i] = simulatePattern(jobs[i], nullptr, *scratch[threadIndex], log);
+
+		std::lock_guard<std::mutex> lock(logMutex);
+		std::cout << log.str();
+	});
+	milliseconds = timer.GetMilliseconds();
+	return edges;
+}
+
+static void printThroughput(size_t patterns, unsigned int threads, float32 milliseconds)
+{
+	float32 seconds = milliseconds / 1000.0f;
+	std::cout << patterns << " patterns on " << threads << " threads in " << seconds << " s, "
+		<< (seconds > 0.0f ? patterns * 3600.0f / seconds : 0.0f) << " patterns per hour" << std::endl;
+}
+
+unsigned int runBatchJobs(const std::vector<BatchJob>& jobs, unsigned int threads)
+{
+	ThreadPool pool(threads);
+
+	float32 milliseconds;
+	std::vector<std::vector<Edge>> edges = simulatePatterns(jobs, pool, milliseconds);
+
+	unsigned int saved = 0;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		if (saveImage(jobs[i], edges[i], std::cout)) saved++;
+	}
+
+	printThroughput(jobs.size(), pool.getThreadCount(), milliseconds);
+	return saved;
+}
+
+bool runStressTest(const std::vector<BatchJob>& jobs, unsigned int threads)
+{
+	ThreadPool pool(threads);
+	ThreadPool calling(1);
+
+	float32 concurrentMilliseconds, sequentialMilliseconds;
+	std::vector<std::vector<Edge>> concurrent = simulatePatterns(jobs, pool, concurrentMilliseconds);
+	std::vector<std::vector<Edge>> sequential = simulatePatterns(jobs, calling, sequentialMilliseconds);
+
+	// Every world is deterministic on its own, so anything shared between them shows up as a difference
+	unsigned int mismatches = 0;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		bool same = concurrent[i].size() == sequential[i].size();
+		for (size_t e = 0; same && e < concurrent[i].size(); e++) {
+			same = memcmp(&concurrent[i][e], &sequential[i][e], sizeof(Edge)) == 0;
+		}
+		if (!same) {
+			std::cout << "Seed " << jobs[i].seed << " differs when run concurrently" << std::endl;
+			mismatches++;
+		}
+	}
+
+	std::cout << "Concurrent: ";
+	printThroughput(jobs.size(), pool.getThreadCount(), concurrentMilliseconds);
+	std::cout << "One at a time: ";
+	printThroughput(jobs.size(), 1, sequentialMilliseconds);
+	std::cout << (mismatches == 0 ? "Stress test passed, every pattern is identical." : "Stress test failed.") << std::endl;
+	return mismatches == 0;
+}
+
+bool runBatch(const BatchJob& job)
+{
+	if (job.benchmark) return runStepBenchmark(job);
+	if (job.kernelCheck) return runKernelCheck(job);
+	if (job.stress) return runStressTest(expandBatchJobs(job), job.patternThreads);
+	if (job.patterns > 1) {
+		std::vector<BatchJob> jobs = expandBatchJobs(job);
+		return runBatchJobs(jobs, job.patternThreads) == jobs.size();
+	}
+	return runBatchJob(job);
+}
+
+bool runStepBenchmark(const BatchJob& job)
+{
+	ConvergenceCriteria settle = job.settle;
+	if (!settle.isEnabled()) settle.maxSpeed = 0.01f;
+
+	ThreadPool threadPool(job.threads);
+	PatternScratch scratch;
+
+	for (STEP_MODE mode : { STEP_MODE_ITERATIONS, STEP_MODE_SUBSTEP }) {
+		StepSettings stepping = job.stepping;
+		stepping.mode = mode;
+
+		if (mode == STEP_MODE_ITERATIONS) {
+			std::cout << "Iterations: " << stepping.velocityIterations << " velocity, " << stepping.positionIterations << " position" << std::endl;
+		}
+		else {
+			std::cout << "Sub-steps: " << stepping.substeps << " x " << stepping.substepIterations << " velocity iterations, joints at "
+				<< stepping.jointHertz << " Hz" << std::endl;
+		}
+
+		// Same seed, so both modes simulate the same pattern
+		b2World world(b2Vec2(0.0f, 0.0f));
+		SpringWorld sWorld(&world, job.seed);
+		sWorld.setThreadPool(&threadPool);
+
+		float32 milliseconds = simulateJob(job, stepping, settle, sWorld, scratch, std::cout);
+		unsigned int steps = sWorld.getStepCount();
+
+		std::cout << "  " << (milliseconds > 0.0f ? steps * 1000.0f / milliseconds : 0.0f) << " steps/second" << std::endl;
+		if (sWorld.hasConverged()) {
+			std::cout << "  Settled in " << milliseconds / 1000.0f << " s (" << steps * job.timeStep << " s simulated)" << std::endl;
+		}
+		else {
+			std::cout << "  Did not settle in " << milliseconds / 1000.0f << " s" << std::endl;
+		}
+	}
+	return true;
+}
+
+bool runKernelCheck(const BatchJob& job)
+{
+	// The batched kernel's atan2 on its own, over every direction
+	float32 atanError = 0.0f;
+	for (unsigned int i = 0; i < 3600; i++) {
+		float32 angle = i * (2.0f * b2_pi / 3600.0f);
+		float32 x = cosf(angle), y = sinf(angle);
+		atanError = b2Max(atanError, std::abs(approxAtan2(y, x) - atan2f(y, x)));
+	}
+	std::cout << "Largest approxAtan2 error: " << atanError << " radians" << std::endl;
+
+	// Same seed, so both kernels simulate the same pattern
+	const FORCE_KERNEL kernels[2] = { FORCE_KERNEL_REFERENCE, FORCE_KERNEL_BATCHED };
+	std::vector<Edge> edges[2];
+	ThreadPool threadPool(job.threads);
+	PatternScratch scratch;
+	for (unsigned int i = 0; i < 2; i++) {
+		BatchJob kernelJob = job;
+		kernelJob.forceKernel = kernels[i];
+		std::cout << (kernels[i] == FORCE_KERNEL_REFERENCE ? "Reference kernel:" : "Batched kernel:") << std::endl;
+		edges[i] = simulatePattern(kernelJob, &threadPool, scratch, std::cout);
+	}
+
+	// Spring ends are the positions of the bodies they join
+	if (edges[0].size() != edges[1].size()) {
+		std::cout << "Kernel check failed, the kernels made different numbers of springs." << std::endl;
+		return false;
+	}
+	float32 largest = 0.0f;
+	for (size_t i = 0; i < edges[0].size(); i++) {
+		largest = b2Max(largest, b2Max((edges[0][i].a - edges[1][i].a).Length(), (edges[0][i].b - edges[1][i].b).Length()));
+	}
+
+	bool passed = largest <= job.kernelTolerance;
+	std::cout << "Largest body position difference: " << largest << " m (tolerance " << job.kernelTolerance << " m), "
+		<< (passed ? "kernel check passed." : "kernel check failed.") << std::endl;
+	return passed;
+}
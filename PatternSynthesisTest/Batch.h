@@ -0,0 +1,73 @@
+#pragma once
+#include <Box2D\Box2D.h>
+
+#include <string>
+#include <vector>
+
+#include "Patterns.h"
+
+// A single headless run: build a pattern, simulate it, save the image. No window and no console prompts.
+struct BatchJob {
+	PatternSettings pattern;
+
+	unsigned int seed = 0;
+	unsigned int maxSteps = 2000; // Simulation stops after this many steps, even if it has not settled
+	float32 timeStep = 1.0f / 60.0f;
+	ConvergenceCriteria settle; // Simulation stops early once these are met. None are set by default, so every step runs
+	bool sleep = false; // Let settled bodies sleep (see SpringWorld::setSleeping)
+	SubdivisionSettings subdivision; // Merge springs that stay straight (see SpringWorld::setSubdivision), off by default
+	StepSettings stepping; // Solver iterations or sub-steps (see SpringWorld::setStepSettings)
+	SPRING_SOLVER springSolver = SPRING_SOLVER_FORCES; // See SpringWorld::setSpringSolver
+	float32 springStiffness = 1.0f;
+	bool benchmark = false; // Time every step mode instead of saving an image (see runStepBenchmark)
+	FORCE_KERNEL forceKernel = FORCE_KERNEL_BATCHED;
+	bool kernelCheck = false; // Compare the force kernels instead of saving an image (see runKernelCheck)
+	float32 kernelTolerance = 1.0f / 30.0f; // Largest difference in body position (m) runKernelCheck allows, one pixel by default
+	unsigned int threads = 0; // Threads for the force pass, 0 = one per core. Use 1 when running one job per core
+	unsigned int patterns = 1; // More than 1 runs this many patterns at once (see expandBatchJobs and runBatchJobs)
+	unsigned int patternThreads = 0; // Patterns run at once, 0 = one per core
+	bool stress = false; // Check the patterns come out the same run at once as one at a time (see runStressTest)
+
+	unsigned int width = 1000; // Output image size in pixels
+	unsigned int height = 1000;
+	std::string outputPath = "output.png";
+};
+
+// Fills job from command line arguments of the form "--key value" (see printBatchUsage)
+// Returns false (after printing why) if any argument is invalid
+bool parseBatchArgs(int argc, char* argv[], BatchJob& job);
+
+// Fills job from a config file with one "key value" or "key = value" pair per line, '#' starts a comment
+bool loadBatchConfig(const std::string& filename, BatchJob& job);
+
+void printBatchUsage();
+
+// Creates the job's pattern, steps it until it settles or runs out of steps and writes the image to job.outputPath
+bool runBatchJob(const BatchJob& job);
+
+// Runs the job once with STEP_MODE_ITERATIONS and once with STEP_MODE_SUBSTEP (using the job's sub-step settings),
+// and prints steps/second and how long each took to settle. Settles at 0.01 m/s if the job has no convergence criteria
+bool runStepBenchmark(const BatchJob& job);
+
+// Simulates the job once with FORCE_KERNEL_REFERENCE and once with FORCE_KERNEL_BATCHED and compares every body's final position
+// Returns false (after printing the difference) if any moved further than job.kernelTolerance apart
+bool runKernelCheck(const BatchJob& job);
+
+// Copies of job with seeds job.seed to job.seed + job.patterns - 1, "output.png" is saved as "output_<seed>.png"
+std::vector<BatchJob> expandBatchJobs(const BatchJob& job);
+
+// Runs independent jobs at once on a pool of threads (0 = one per core), one pattern per thread
+// Every pattern gets its own b2World and SpringWorld and runs on a single thread, job.threads is ignored
+// Prints the throughput in patterns per hour and returns how many images were saved
+unsigned int runBatchJobs(const std::vector<BatchJob>& jobs, unsigned int threads);
+
+// Runs the jobs at once like runBatchJobs, then one at a time, and checks every pattern's springs are bit-identical
+// Nothing is saved. Anything the worlds share that is not thread-safe shows up as a difference
+bool runStressTest(const std::vector<BatchJob>& jobs, unsigned int threads);
+
+// Runs the job the way its options ask for: a benchmark, a kernel check, a stress test, several patterns or a single one
+bool runBatch(const BatchJob& job);
+
+// Software rasterizes edges (in world units) as black anti-aliased lines on a white RGBA8 image
+// Does not need a window or OpenGL context, so it works on machines with no display
+void rasterizeEdges(const std::vector<Edge>& edges, unsigned int width, unsigned int height, std::vector<uint8>& pixels);
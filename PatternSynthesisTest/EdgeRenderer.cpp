@@ -0,0 +1,72 @@
+#include "EdgeRenderer.h"
+
+#include <cmath>
+
+// Same scale as main.cpp: 1 Meter = 30 pixels
+static const float SCALE = 30.f;
+
+EdgeRenderer::EdgeRenderer(EDGE_RENDER_MODE mode, float32 thickness)
+{
+	setMode(mode, thickness);
+}
+
+void EdgeRenderer::setMode(EDGE_RENDER_MODE mode, float32 thickness)
+{
+	this->mode = mode;
+	this->thickness = thickness;
+
+	vertices.setPrimitiveType(mode == EDGE_RENDER_QUADS ? sf::Quads : sf::Lines);
+	vertices.clear(); // Vertex count per spring changed, update resizes it
+}
+
+EDGE_RENDER_MODE EdgeRenderer::getMode() const
+{
+	return mode;
+}
+
+void EdgeRenderer::setColor(sf::Color color)
+{
+	this->color = color;
+	for (unsigned int i = 0; i < vertices.getVertexCount(); i++) vertices[i].color = color;
+}
+
+void EdgeRenderer::update(const SpringWorld& sWorld, sf::Vector2u targetSize)
+{
+	unsigned int verticesPerEdge = mode == EDGE_RENDER_QUADS ? 4 : 2;
+	unsigned int numSprings = sWorld.getSpringCount();
+
+	if (vertices.getVertexCount() != numSprings * verticesPerEdge) {
+		vertices.resize(numSprings * verticesPerEdge);
+		for (unsigned int i = 0; i < vertices.getVertexCount(); i++) vertices[i].color = color;
+	}
+
+	sf::Vector2f offset(targetSize.x / 2.0f, targetSize.y / 2.0f);
+	float32 halfThickness = thickness / 2.0f;
+
+	sWorld.forEachSpringEdge([&](unsigned int i, const b2Vec2& bodyA, const b2Vec2& bodyB) {
+		sf::Vector2f a = sf::Vector2f(bodyA.x * SCALE, bodyA.y * SCALE) + offset;
+		sf::Vector2f b = sf::Vector2f(bodyB.x * SCALE, bodyB.y * SCALE) + offset;
+
+		sf::Vertex* v = &vertices[i * verticesPerEdge];
+		if (mode == EDGE_RENDER_LINES) {
+			v[0].position = a;
+			v[1].position = b;
+			return;
+		}
+
+		// Offset both ends sideways by half the thickness
+		sf::Vector2f dir = b - a;
+		float32 length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+		sf::Vector2f side = length > 0.0f ? sf::Vector2f(-dir.y, dir.x) * (halfThickness / length) : sf::Vector2f(halfThickness, 0.0f);
+
+		v[0].position = a + side;
+		v[1].position = b + side;
+		v[2].position = b - side;
+		v[3].position = a - side;
+	});
+}
+
+void EdgeRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	target.draw(vertices, states);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <SFML\Graphics.hpp>
+#include <Box2D\Box2D.h>
+
+#include "Springs.h"
+
+enum EDGE_RENDER_MODE {
+	EDGE_RENDER_LINES, // One pixel wide lines, 2 vertices per spring
+	EDGE_RENDER_QUADS // Filled quads of any thickness, 4 vertices per spring
+};
+
+// Draws every spring of a SpringWorld in a single draw call
+// The vertex array is kept between frames, update only rewrites vertex positions (and only reallocates when the spring count changes)
+struct EdgeRenderer : public sf::Drawable {
+
+public:
+	EdgeRenderer(EDGE_RENDER_MODE mode = EDGE_RENDER_LINES, float32 thickness = 2.0f);
+
+	// thickness: line width in pixels, only used by EDGE_RENDER_QUADS
+	void setMode(EDGE_RENDER_MODE mode, float32 thickness = 2.0f);
+	EDGE_RENDER_MODE getMode() const;
+
+	void setColor(sf::Color color);
+
+	// Rebuilds vertex positions from the current body positions
+	// targetSize: size of the target in pixels, world origin is drawn at its centre
+	void update(const SpringWorld& sWorld, sf::Vector2u targetSize);
+
+private:
+	EDGE_RENDER_MODE mode;
+	float32 thickness;
+	sf::Color color = sf::Color::Black;
+
+	sf::VertexArray vertices;
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
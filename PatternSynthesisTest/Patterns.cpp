@@ -0,0 +1,116 @@
+#include "Patterns.h"
+#include "Voronoi.h"
+
+#include <iostream>
+
+static const float INVSCALE = 1.0f / 30.0f;
+
+void createPattern(SpringWorld* sWorld, const PatternSettings& settings, unsigned int screenWidth, unsigned int screenHeight, PatternScratch* scratch, std::ostream& log)
+{
+	PatternScratch localScratch; // Only allocates if it gets used
+	PatternScratch& patternScratch = scratch ? *scratch : localScratch;
+	VoronoiArena& voronoiArena = patternScratch.arena;
+
+	// Only used by the Voronoi patterns
+	Voronoi& v = patternScratch.voronoi;
+	v.setThreadPool(sWorld->getThreadPool());
+	v.setRelaxation(settings.relaxIterations);
+	v.setTiling(settings.voronoiTiles);
+	v.setMinDistance(settings.minDistance * INVSCALE);
+
+	Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
+
+	switch (settings.type) {
+	case PATTERN_LINE:
+		log << "Creating line." << std::endl;
+		sWorld->createSpringLine(b2Vec2(-10.0f, 0.0f), b2Vec2(10.0f, 0.0f), settings.size, RASFSettings(settings.rasfType, settings.rasfValue));
+		sWorld->initSpringWorld();
+		break;
+	case PATTERN_BOX:
+		log << "Creating box." << std::endl;
+		sWorld->createSpringBox(settings.size, settings.rasfType, settings.rasfValue);
+		break;
+	case PATTERN_SQUIGGLE:
+		log << "Creating test squiggle." << std::endl;
+		sWorld->createSquiggle(settings.size, settings.rasfType, settings.rasfValue);
+		break;
+	case PATTERN_VORONOI:
+	{
+		log << "Creating Voronoi diagram." << std::endl;
+		v.generate(screenWidth * INVSCALE, screenHeight * INVSCALE, settings.size, sWorld->getRandom(), RANDOM, voronoiArena);
+		sWorld->createSystem(b, v.graph, settings.rasfType, settings.rasfValue);
+	}
+		break;
+	case PATTERN_FRACTAL_TREE:
+		sWorld->createFractalTree(settings.size, settings.rasfType, settings.rasfValue);
+		break;
+	case PATTERN_RANDOMIZED_FRACTAL_TREE:
+		sWorld->createRandomizedFractalTree(settings.size, settings.rasfType, settings.rasfValue);
+		break;
+	case PATTERN_UNIFORM_RANDOM_VORONOI:
+	{
+		log << "Creating Voronoi diagram." << std::endl;
+		v.generate(screenWidth * INVSCALE, screenHeight * INVSCALE, settings.size, sWorld->getRandom(), UNIFORM_RANDOM, voronoiArena);
+		sWorld->createSystem(b, v.graph, settings.rasfType, settings.rasfValue);
+	}
+		break;
+	case PATTERN_CENTROIDAL_VORONOI:
+	{
+		log << "Creating centroidal Voronoi diagram." << std::endl;
+		v.generate(screenWidth * INVSCALE, screenHeight * INVSCALE, settings.size, sWorld->getRandom(), CENTROIDAL, voronoiArena);
+		sWorld->createSystem(b, v.graph, settings.rasfType, settings.rasfValue);
+	}
+		break;
+	case PATTERN_POISSON_VORONOI:
+	{
+		log << "Creating Poisson-disk Voronoi diagram." << std::endl;
+		v.generate(screenWidth * INVSCALE, screenHeight * INVSCALE, settings.size, sWorld->getRandom(), POISSON_DISK, voronoiArena);
+		sWorld->createSystem(b, v.graph, settings.rasfType, settings.rasfValue);
+	}
+		break;
+	case PATTERN_UNIFORM_GRID:
+	{
+		log << "Creating Voronoi diagram." << std::endl;
+		v.generate(screenWidth * INVSCALE, screenHeight * INVSCALE, settings.size * settings.size, sWorld->getRandom(), UNIFORM, voronoiArena);
+		sWorld->createSystem(b, v.graph, settings.rasfType, settings.rasfValue);
+	}
+		break;
+	}
+}
+
+bool parsePatternType(const std::string& str, PATTERN_TYPE& type)
+{
+	// Menu numbers match decidePatternToCreate
+	static const char* names[] = { "line", "box", "squiggle", "voronoi", "tree", "random-tree", "uniform-voronoi", "grid", "centroidal-voronoi", "poisson-voronoi" };
+
+	for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		if (str == names[i] || str == std::to_string(i + 1)) {
+			type = (PATTERN_TYPE)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool parseRASFType(const std::string& str, RASF_TYPE& type)
+{
+	// Menu numbers match decideRASFType (which does not follow the RASF_TYPE order)
+	static const struct { const char* name; RASF_TYPE type; } names[] = {
+		{ "constant", RASF_CONSTANT },
+		{ "lerp", RASF_BASIC_LERP },
+		{ "average", RASF_AVERAGE },
+		{ "randomized", RASF_RANDOMIZED },
+		{ "sin", RASF_SINWAVE },
+		{ "pseudorandom", RASF_PSEUDORANDOM },
+		{ "sequential-sin", RASF_SEQUENTIAL_SIN },
+		{ "sequential-sin-lerp", RASF_SEQUENTIAL_SIN_PLUS_LERP }
+	};
+
+	for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		if (str == names[i].name || str == std::to_string(i + 1)) {
+			type = names[i].type;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <Box2D\Box2D.h>
+
+#include <string>
+#include <iostream>
+
+#include "Springs.h"
+
+enum PATTERN_TYPE {
+	PATTERN_LINE,
+	PATTERN_BOX,
+	PATTERN_SQUIGGLE,
+	PATTERN_VORONOI,
+	PATTERN_FRACTAL_TREE,
+	PATTERN_RANDOMIZED_FRACTAL_TREE,
+	PATTERN_UNIFORM_RANDOM_VORONOI,
+	PATTERN_UNIFORM_GRID,
+	PATTERN_CENTROIDAL_VORONOI,
+	PATTERN_POISSON_VORONOI
+};
+
+// Everything needed to build a pattern without asking the user anything
+struct PatternSettings {
+	PATTERN_TYPE type = PATTERN_VORONOI;
+	// Springs in line/per side, number of Voronoi points, fractal depth or size of one side of grid (depends on type)
+	unsigned int size = 100;
+	RASF_TYPE rasfType = RASF_CONSTANT;
+	float32 rasfValue = 1.0f; // Either a multiplier value, or an angle in degrees (depends on RASF type)
+	unsigned int relaxIterations = 10; // Lloyd iterations for centroidal Voronoi diagrams
+	float32 minDistance = 0.0f; // Closest two points of a Poisson-disk Voronoi diagram can be in pixels, 0 to pick it from size
+	unsigned int voronoiTiles = 1; // Tiles per side to generate Voronoi diagrams in parallel, the edges are the same but their order (and so the pattern) changes
+};
+
+// Memory for building Voronoi diagrams, kept between patterns so creating many of them stops touching the system allocator
+// Not thread-safe, keep one per thread when creating patterns on several threads
+struct PatternScratch {
+	VoronoiArena arena;
+	Voronoi voronoi;
+};
+
+// Creates the given pattern in sWorld and initializes it, ready to be updated
+// screenWidth/screenHeight: size of the image in pixels, Voronoi diagrams fill the whole image
+// scratch: pass the same one when creating many patterns so its memory is reused (nullptr for a temporary one)
+// log: where progress is written, give each thread its own when creating patterns on several threads
+void createPattern(SpringWorld* sWorld, const PatternSettings& settings, unsigned int screenWidth, unsigned int screenHeight, PatternScratch* scratch = nullptr, std::ostream& log = std::cout);
+
+// Parses a pattern/RASF type from either its name (e.g. "voronoi", "lerp") or its menu number (e.g. "4")
+// Returns false if the string is not recognised
+bool parsePatternType(const std::string& str, PATTERN_TYPE& type);
+bool parseRASFType(const std::string& str, RASF_TYPE& type);
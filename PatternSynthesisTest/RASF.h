@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <Box2D\Box2D.h>
 
 #include "util.h"
@@ -7,8 +8,6 @@
 constexpr auto DEGTORAD = 0.0174532925199432957f;
 constexpr auto RADTODEG = 57.295779513082320876f;
 
-#define RASF std::function<float32(std::vector<float32>, std::vector<float32>, float32, unsigned int)>
-
 enum RASF_TYPE {
 	RASF_CONSTANT,
 	RASF_AVERAGE,
@@ -25,230 +24,281 @@ inline float32 lerp(float32 a, float32 b, float32 t)
 	return a + (t * (b - a));
 }
 
-static RASF getLerpRASF(float32 multiplier) {
-	auto lerpRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		float32 ret = 0.0f;
+// How far along the spring line spring i is, from 0 to 1
+inline float32 springT(unsigned int i, unsigned int numSegments)
+{
+	return (float32)i / (float32)numSegments;
+}
 
-		// Lerp
-		float32 start = 0.0f;
-		for (float32 angle : startAngles) {
-			if (abs(angle) > abs(start)) start = angle;
-		}
-		float32 end = 0.0f;
-		for (float32 angle : endAngles) {
-			if (abs(angle) > abs(end)) end = angle;
-		}
+// Connected angle with the largest magnitude (0 if there are none)
+inline float32 largestAngle(const std::vector<float32>& angles)
+{
+	float32 largest = 0.0f;
+	for (float32 angle : angles) {
+		if (abs(angle) > abs(largest)) largest = angle;
+	}
+	return largest;
+}
 
-		float32 invNumSegments = 1.0f / (float32)numSegments;
-		float32 minimizer = 0.1f;
-		ret = multiplier * invNumSegments * lerp(-start, end, T);
-		//ret = multiplier * minimizer * lerp(-start, end, T);
-		return ret;
-	};
+// Average of the connected angles, start angles flipped to match the line's direction
+inline float32 averageAngle(const std::vector<float32>& startAngles, const std::vector<float32>& endAngles)
+{
+	float32 averageAngle = 0.0f;
+	for (float32 angle : startAngles) averageAngle += -angle;
+	for (float32 angle : endAngles) averageAngle += angle;
+	averageAngle /= startAngles.size() + endAngles.size();
+	return averageAngle;
+}
 
-	return lerpRASF;
+// Random sin wave locations along a line for the sequential sin RASFs, starting at 0 and ending somewhere within 0.15 of 1
+inline std::vector<float32> getSinBeginLocations(Random& rng)
+{
+	std::vector<float32> sinBeginLocations;
+	// First sin wave begin location always at start
+	sinBeginLocations.push_back(0.0f);
+	unsigned int currentBeginLocation = 0;
+
+	while (true) {
+		sinBeginLocations.push_back(RandomFloat(rng, sinBeginLocations[currentBeginLocation], 1.0f));
+		currentBeginLocation++;
+		// If close to end, no more sin waves
+		if (1.0f - sinBeginLocations[currentBeginLocation] < 0.15f) {
+			break;
+		}
+	}
+	return sinBeginLocations;
 }
 
-static RASF getAveAngleRASF(float32 multiplier) {
-	auto aveAngleRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
+// Everything a RASF gets to know about the spring line it sets rest angles for
+struct RASFLine {
+	const std::vector<float32>& startAngles;
+	const std::vector<float32>& endAngles;
+	unsigned int numSegments;
+	Random& rng; // The spring line's own generator
+};
 
-		float32 invNumSegments = 1.0f / (float32)numSegments;
+// RASF evaluators
+// Each one is a small struct with a plan function, that works out anything that only depends on the line once
+// (largest/average end angle, sin wave locations, random numbers) and returns a Plan. plan(i) is then the rest angle of spring i
+// Plans are const and only depend on i, so springs can be evaluated in any order, split across threads or run in SIMD lanes
+// Random RASFs draw every number they need in plan, in spring order, so the line's generator is only used there
+// Everything is resolved at compile time, so filling a line is a plain loop the compiler can inline (see fillRestAngles)
 
-		float32 averageAngle = 0.0f;
-		for (float32 angle : startAngles) averageAngle += -angle;
-		for (float32 angle : endAngles) averageAngle += angle;
-		averageAngle /= startAngles.size() + endAngles.size();
-		return multiplier * invNumSegments * averageAngle;
+struct ConstantRASF {
+	float32 angle; // In degrees
+	ConstantRASF(float32 angle) : angle(angle) {}
 
+	struct Plan {
+		float32 restAngle;
+		float32 operator()(unsigned int) const { return restAngle; }
 	};
+	Plan plan(const RASFLine&) const { return { angle * DEGTORAD }; }
+};
 
-	return aveAngleRASF;
-}
+struct LerpRASF {
+	float32 multiplier;
+	LerpRASF(float32 multiplier) : multiplier(multiplier) {}
 
-static RASF getConstantRASF(float32 angle) {
-	auto constantRASF = [angle](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		return angle * DEGTORAD;
+	struct Plan {
+		float32 multiplier, invNumSegments;
+		float32 start, end;
+		unsigned int numSegments;
+		float32 operator()(unsigned int i) const { return multiplier * invNumSegments * lerp(-start, end, springT(i, numSegments)); }
 	};
+	Plan plan(const RASFLine& line) const {
+		return { multiplier, 1.0f / (float32)line.numSegments, largestAngle(line.startAngles), largestAngle(line.endAngles), line.numSegments };
+	}
+};
 
-	return constantRASF;
-}
-
-static RASF getRandomizedRASF(float32 multiplier) {
-	auto randomizedRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		float32 invNumSegments = 1.0f / (float32)numSegments;
-		float32 minimizer = 0.1f;
+struct AverageAngleRASF {
+	float32 multiplier;
+	bool perSegment; // Divide by the number of segments, so the line turns by the average angle in total
+	AverageAngleRASF(float32 multiplier, bool perSegment = true) : multiplier(multiplier), perSegment(perSegment) {}
 
-		return multiplier * invNumSegments * RandomFloat(-90.0f * DEGTORAD, 90.0f * DEGTORAD);
+	struct Plan {
+		float32 restAngle;
+		float32 operator()(unsigned int) const { return restAngle; }
 	};
+	Plan plan(const RASFLine& line) const {
+		float32 average = averageAngle(line.startAngles, line.endAngles);
+		if (!perSegment) return { multiplier * average };
+		float32 invNumSegments = 1.0f / (float32)line.numSegments;
+		return { multiplier * invNumSegments * average };
+	}
+};
 
-	return randomizedRASF;
-}
+struct RandomizedRASF {
+	float32 multiplier;
+	RandomizedRASF(float32 multiplier) : multiplier(multiplier) {}
 
-static RASF getSINWaveRASF(float32 multiplier) {
-	auto SINWaveRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		float32 ret = sin(T * (2 * b2_pi)) * multiplier;
-		return ret;
+	struct Plan {
+		float32 multiplier, invNumSegments;
+		std::vector<float32> angles; // Random angle of each spring
+		float32 operator()(unsigned int i) const { return multiplier * invNumSegments * angles[i]; }
 	};
+	Plan plan(const RASFLine& line) const {
+		Plan p = { multiplier, 1.0f / (float32)line.numSegments, std::vector<float32>(line.numSegments) };
+		for (float32& angle : p.angles) angle = RandomFloat(line.rng, -90.0f * DEGTORAD, 90.0f * DEGTORAD);
+		return p;
+	}
+};
 
-	return SINWaveRASF;
-}
-
-static RASF getPseudorandomRASF(float32 multiplier) {
-	auto pseudoRandRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		float32 ret = 0;
-		unsigned int numInLine = T * numSegments;
-		float32 minimizer = 0.4;
+struct SINWaveRASF {
+	float32 multiplier;
+	SINWaveRASF(float32 multiplier) : multiplier(multiplier) {}
 
-		// Alternate positive and negative random float
-		if (numInLine % 4 <= 1) {
-			ret = minimizer * RandomFloat(-90.0f * DEGTORAD, 0.0f * DEGTORAD);
-		}
-		else {
-			ret = minimizer * RandomFloat(0.0f * DEGTORAD, 90.0f * DEGTORAD);
-		}
-		return ret;
+	struct Plan {
+		float32 multiplier;
+		unsigned int numSegments;
+		float32 operator()(unsigned int i) const { return sin(springT(i, numSegments) * (2 * b2_pi)) * multiplier; }
 	};
+	Plan plan(const RASFLine& line) const { return { multiplier, line.numSegments }; }
+};
 
-	return pseudoRandRASF;
-}
+struct PseudorandomRASF {
+	PseudorandomRASF(float32) {} // Multiplier is not used
 
-static RASF getSequentialSinRASF(float32 multiplier) {
-	auto sequentialSinRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		// Set random seed equal to numSegments so that springs in the same spring line will have the same random results for continuity in a single spring line
-		// ... Yeah this is bad and needs refactoring so that RASF can carry over information from one spring to the next in a a single spring line, but there's
-		// no time right now.
-		srand(numSegments);
-		float32 ret = 0;
-
-		std::vector<float32> sinBeginLocations;
-		// First sin wave begin location always at start
-		sinBeginLocations.push_back(0.0f);
-		unsigned int currentBeginLocation = 0;
-
-		while (true) {
-			sinBeginLocations.push_back(RandomFloat(sinBeginLocations[currentBeginLocation], 1.0f));
-			currentBeginLocation++;
-			// If close to end, no more sin waves
-			if (1.0f - sinBeginLocations[currentBeginLocation] < 0.15f) {
-				break;
+	struct Plan {
+		std::vector<float32> angles; // Rest angle of each spring
+		float32 operator()(unsigned int i) const { return angles[i]; }
+	};
+	Plan plan(const RASFLine& line) const {
+		Plan p;
+		p.angles.resize(line.numSegments);
+		for (unsigned int i = 0; i < line.numSegments; i++) {
+			unsigned int numInLine = springT(i, line.numSegments) * line.numSegments;
+			float32 minimizer = 0.4;
+
+			// Alternate positive and negative random float
+			if (numInLine % 4 <= 1) {
+				p.angles[i] = minimizer * RandomFloat(line.rng, -90.0f * DEGTORAD, 0.0f * DEGTORAD);
 			}
-		}
-		unsigned int whichSegment = 0;
-		// Check where current T is
-		for (unsigned int i = 1; i < sinBeginLocations.size(); i++) {
-			if (T < sinBeginLocations[i]) {
-				whichSegment = i;
-				break;
+			else {
+				p.angles[i] = minimizer * RandomFloat(line.rng, 0.0f * DEGTORAD, 90.0f * DEGTORAD);
 			}
-			whichSegment = i;
 		}
-		// Check how far through current sin wave T is
-		float32 sinSegmentLength = sinBeginLocations[whichSegment] - sinBeginLocations[whichSegment - 1];
-		float32 howFarThrough = (T - sinBeginLocations[whichSegment - 1]) / sinSegmentLength;
+		return p;
+	}
+};
 
-		ret = (1.0f - sinSegmentLength) * sin(howFarThrough * (2 * b2_pi)) * multiplier;
-		
-		return ret;
-	};
+struct SequentialSinRASF {
+	float32 multiplier;
+	float32 scale; // Applied after the multiplier
+	SequentialSinRASF(float32 multiplier, float32 scale = 1.0f) : multiplier(multiplier), scale(scale) {}
 
-	return sequentialSinRASF;
-}
+	// Wave locations are picked once for the whole line, for continuity in a single spring line
+	struct Plan {
+		float32 multiplier, scale;
+		unsigned int numSegments;
+		std::vector<float32> sinBeginLocations; // Sorted, so the wave a spring is in can be binary searched
 
-static RASF RASFgetSequentialSinPlusLERPRASF(float32 multiplier) {
-	auto sequentialSinPlusLERPRASF = [multiplier](std::vector<float32> startAngles, std::vector<float32> endAngles, float32 T, unsigned int numSegments) {
-		// Set random seed equal to numSegments so that springs in the same spring line will have the same random results for continuity in a single spring line
-		// ... Yeah this is bad and needs refactoring so that RASF can carry over information from one spring to the next in a a single spring line, but there's
-		// no time right now.
-		srand(numSegments);
-		float32 ret = 0;
-
-		std::vector<float32> sinBeginLocations;
-		// First sin wave begin location always at start
-		sinBeginLocations.push_back(0.0f);
-		unsigned int currentBeginLocation = 0;
-
-		while (true) {
-			sinBeginLocations.push_back(RandomFloat(sinBeginLocations[currentBeginLocation], 1.0f));
-			currentBeginLocation++;
-			// If close to end, no more sin waves
-			if (1.0f - sinBeginLocations[currentBeginLocation] < 0.15f) {
-				break;
-			}
-		}
-		unsigned int whichSegment = 0;
-		// Check where current T is
-		for (unsigned int i = 1; i < sinBeginLocations.size(); i++) {
-			if (T < sinBeginLocations[i]) {
-				whichSegment = i;
-				break;
-			}
-			whichSegment = i;
+		float32 operator()(unsigned int i) const {
+			float32 T = springT(i, numSegments);
+
+			// First wave that T is before the end of (or the last wave)
+			unsigned int whichSegment = (unsigned int)(std::upper_bound(sinBeginLocations.begin() + 1, sinBeginLocations.end() - 1, T) - sinBeginLocations.begin());
+
+			// Check how far through current sin wave T is
+			float32 sinSegmentLength = sinBeginLocations[whichSegment] - sinBeginLocations[whichSegment - 1];
+			float32 howFarThrough = (T - sinBeginLocations[whichSegment - 1]) / sinSegmentLength;
+
+			return (1.0f - sinSegmentLength) * sin(howFarThrough * (2 * b2_pi)) * multiplier * scale;
 		}
-		// Check how far through current sin wave T is
-		float32 sinSegmentLength = sinBeginLocations[whichSegment] - sinBeginLocations[whichSegment - 1];
-		float32 howFarThrough = (T - sinBeginLocations[whichSegment - 1]) / sinSegmentLength;
-
-		ret = (1.0f - sinSegmentLength) * sin(howFarThrough * (2 * b2_pi)) * multiplier * 3.0f;
-		
-		//// LERP segment
-		//float32 start = 0.0f;
-		//for (float32 angle : startAngles) {
-		//	if (abs(angle) > abs(start)) start = angle;
-		//}
-		//float32 end = 0.0f;
-		//for (float32 angle : endAngles) {
-		//	if (abs(angle) > abs(end)) end = angle;
-		//}
-
-		//float32 invNumSegments = 1.0f / (float32)numSegments;
-		//float32 minimizer = 0.4f;
-		//ret += multiplier * minimizer * lerp(-start, end, T);
-		float32 invNumSegments = 1.0f / (float32)numSegments;
-
-
-		float32 averageAngle = 0.0f;
-		for (float32 angle : startAngles) averageAngle += -angle;
-		for (float32 angle : endAngles) averageAngle += angle;
-		averageAngle /= startAngles.size() + endAngles.size();
-		ret += 0.4f * multiplier * averageAngle;
-		ret /= 2.0f;
-
-		return ret;
 	};
+	Plan plan(const RASFLine& line) const { return { multiplier, scale, line.numSegments, getSinBeginLocations(line.rng) }; }
+};
+
+// Composition: A's rest angle plus B's
+template <typename A, typename B>
+struct RASFSum {
+	A a;
+	B b;
+	RASFSum(const A& a, const B& b) : a(a), b(b) {}
+
+	struct Plan {
+		typename A::Plan a;
+		typename B::Plan b;
+		float32 operator()(unsigned int i) const { return a(i) + b(i); }
+	};
+	Plan plan(const RASFLine& line) const {
+		typename A::Plan planA = a.plan(line); // A before B, so random RASFs always draw in the same order
+		return { planA, b.plan(line) };
+	}
+};
+
+// Composition: A's rest angle multiplied by scale
+template <typename A>
+struct RASFScale {
+	A a;
+	float32 scale;
+	RASFScale(const A& a, float32 scale) : a(a), scale(scale) {}
+
+	struct Plan {
+		typename A::Plan a;
+		float32 scale;
+		float32 operator()(unsigned int i) const { return a(i) * scale; }
+	};
+	Plan plan(const RASFLine& line) const { return { a.plan(line), scale }; }
+};
+
+template <typename A, typename B>
+RASFSum<A, B> makeRASFSum(const A& a, const B& b) { return RASFSum<A, B>(a, b); }
 
-	return sequentialSinPlusLERPRASF;
+template <typename A>
+RASFScale<A> makeRASFScale(const A& a, float32 scale) { return RASFScale<A>(a, scale); }
+
+// Sequential sin wave (3x as strong) averaged with the average angle of the connected lines
+inline RASFScale<RASFSum<SequentialSinRASF, AverageAngleRASF>> makeSequentialSinPlusLerpRASF(float32 multiplier) {
+	return makeRASFScale(makeRASFSum(SequentialSinRASF(multiplier, 3.0f), AverageAngleRASF(0.4f * multiplier, false)), 0.5f);
+}
+
+// Fills restAngles[i] for every spring i of the line
+template <typename Evaluator>
+void fillRestAngles(const Evaluator& rasf, const RASFLine& line, float32* restAngles) {
+	const auto plan = rasf.plan(line);
+	for (unsigned int i = 0; i < line.numSegments; i++) {
+		restAngles[i] = plan(i);
+	}
 }
 
-// type: Type of rest angle function to get
+// A RASF picked at run time, e.g. from the menu or the command line
 // value: parameter for rest angle function (depends on type)
-static RASF getRASF(RASF_TYPE type, float32 value = 1.0f) {
-	switch (type) {
+struct RASFSettings {
+	RASF_TYPE type;
+	float32 value;
+	RASFSettings(RASF_TYPE type = RASF_CONSTANT, float32 value = 1.0f) : type(type), value(value) {}
+};
+
+// Switches on the type once per line, then fills the line with that type's evaluator
+inline void fillRestAngles(const RASFSettings& settings, const RASFLine& line, float32* restAngles) {
+	float32 value = settings.value;
+	switch (settings.type) {
 	case RASF_CONSTANT:
-		return getConstantRASF(value);
+		fillRestAngles(ConstantRASF(value), line, restAngles);
+		break;
 	case RASF_AVERAGE:
-		return getAveAngleRASF(value);
+		fillRestAngles(AverageAngleRASF(value), line, restAngles);
 		break;
 	case RASF_BASIC_LERP:
-		return getLerpRASF(value);
+		fillRestAngles(LerpRASF(value), line, restAngles);
 		break;
 	case RASF_RANDOMIZED:
-		return getRandomizedRASF(value);
+		fillRestAngles(RandomizedRASF(value), line, restAngles);
 		break;
 	case RASF_SINWAVE:
-		return getSINWaveRASF(value);
+		fillRestAngles(SINWaveRASF(value), line, restAngles);
 		break;
 	case RASF_PSEUDORANDOM:
-		return getPseudorandomRASF(value);
+		fillRestAngles(PseudorandomRASF(value), line, restAngles);
 		break;
 	case RASF_SEQUENTIAL_SIN:
-		return getSequentialSinRASF(value);
+		fillRestAngles(SequentialSinRASF(value), line, restAngles);
 		break;
 	case RASF_SEQUENTIAL_SIN_PLUS_LERP:
-		return RASFgetSequentialSinPlusLERPRASF(value);
+		fillRestAngles(makeSequentialSinPlusLerpRASF(value), line, restAngles);
 		break;
 	default:
-		return getConstantRASF(value);
+		fillRestAngles(ConstantRASF(value), line, restAngles);
 		break;
 	}
 }
- 
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "SpringKernel.h"
+#include "Springs.h"
+
+#include <cmath>
+#include <cfloat>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SPRING_KERNEL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPRING_KERNEL_SSE2
+#endif
+
+// Each Lanes type wraps one instruction set so the kernel math below is only written once
+
+struct ScalarLanes {
+	typedef float32 Type;
+	typedef bool Mask;
+	static const unsigned int width = 1;
+
+	static Type set(float32 f) { return f; }
+	static Type load(const float32* p) { return *p; }
+	static void store(float32* p, Type v) { *p = v; }
+
+	static Type add(Type a, Type b) { return a + b; }
+	static Type sub(Type a, Type b) { return a - b; }
+	static Type mul(Type a, Type b) { return a * b; }
+	static Type div(Type a, Type b) { return a / b; }
+	static Type sqrt(Type a) { return std::sqrt(a); }
+	static Type min(Type a, Type b) { return a < b ? a : b; }
+	static Type max(Type a, Type b) { return a > b ? a : b; }
+	static Type abs(Type a) { return std::abs(a); }
+
+	static Mask less(Type a, Type b) { return a < b; }
+	static Mask greater(Type a, Type b) { return a > b; }
+	static Type select(Mask m, Type a, Type b) { return m ? a : b; }
+};
+
+#if defined(SPRING_KERNEL_AVX2)
+struct SimdLanes {
+	typedef __m256 Type;
+	typedef __m256 Mask;
+	static const unsigned int width = 8;
+
+	static Type set(float32 f) { return _mm256_set1_ps(f); }
+	static Type load(const float32* p) { return _mm256_loadu_ps(p); }
+	static void store(float32* p, Type v) { _mm256_storeu_ps(p, v); }
+
+	static Type add(Type a, Type b) { return _mm256_add_ps(a, b); }
+	static Type sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+	static Type mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+	static Type div(Type a, Type b) { return _mm256_div_ps(a, b); }
+	static Type sqrt(Type a) { return _mm256_sqrt_ps(a); }
+	static Type min(Type a, Type b) { return _mm256_min_ps(a, b); }
+	static Type max(Type a, Type b) { return _mm256_max_ps(a, b); }
+	static Type abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+	static Mask less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Mask greater(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Type select(Mask m, Type a, Type b) { return _mm256_blendv_ps(b, a, m); }
+};
+#elif defined(SPRING_KERNEL_SSE2)
+struct SimdLanes {
+	typedef __m128 Type;
+	typedef __m128 Mask;
+	static const unsigned int width = 4;
+
+	static Type set(float32 f) { return _mm_set1_ps(f); }
+	static Type load(const float32* p) { return _mm_loadu_ps(p); }
+	static void store(float32* p, Type v) { _mm_storeu_ps(p, v); }
+
+	static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static Type div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static Type sqrt(Type a) { return _mm_sqrt_ps(a); }
+	static Type min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static Type max(Type a, Type b) { return _mm_max_ps(a, b); }
+	static Type abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+	static Mask less(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+	static Mask greater(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+	static Type select(Mask m, Type a, Type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+#else
+typedef ScalarLanes SimdLanes;
+#endif
+
+// atan on [0, 1], 11th order minimax polynomial
+template <typename L>
+static typename L::Type approxAtanUnit(typename L::Type t)
+{
+	typename L::Type s = L::mul(t, t);
+	typename L::Type p = L::set(-0.01172120f);
+	p = L::add(L::mul(p, s), L::set(0.05265332f));
+	p = L::add(L::mul(p, s), L::set(-0.11643287f));
+	p = L::add(L::mul(p, s), L::set(0.19354346f));
+	p = L::add(L::mul(p, s), L::set(-0.33262347f));
+	p = L::add(L::mul(p, s), L::set(0.99997726f));
+	return L::mul(p, t);
+}
+
+template <typename L>
+static typename L::Type approxAtan2(typename L::Type y, typename L::Type x)
+{
+	typedef typename L::Type T;
+	const T zero = L::set(0.0f);
+
+	T ax = L::abs(x);
+	T ay = L::abs(y);
+
+	// Reduce to [0, 1] then unfold by octant
+	T t = L::div(L::min(ax, ay), L::max(L::max(ax, ay), L::set(FLT_MIN)));
+	T r = approxAtanUnit<L>(t);
+	r = L::select(L::greater(ay, ax), L::sub(L::set(0.5f * b2_pi), r), r);
+	r = L::select(L::less(x, zero), L::sub(L::set(b2_pi), r), r);
+	return L::select(L::less(y, zero), L::sub(zero, r), r);
+}
+
+float32 approxAtan2(float32 y, float32 x)
+{
+	return approxAtan2<ScalarLanes>(y, x);
+}
+
+// Forces for springs [begin, begin + L::width), gathered and scattered through the index arrays
+template <typename L>
+static void springBatch(const SpringStore& springs, const b2Vec2* positions, b2Vec2* forces, unsigned int begin)
+{
+	typedef typename L::Type T;
+	const unsigned int W = L::width;
+
+	// Gather positions, springs without a previous body use their own body so the angle maths stays finite
+	float32 bx[W], by[W], nx[W], ny[W], px[W], py[W], hasPrev[W];
+	for (unsigned int lane = 0; lane < W; lane++) {
+		unsigned int i = begin + lane;
+		int32 prev = springs.prevBody[i];
+
+		bx[lane] = positions[springs.body[i]].x;
+		by[lane] = positions[springs.body[i]].y;
+		nx[lane] = positions[springs.nextBody[i]].x;
+		ny[lane] = positions[springs.nextBody[i]].y;
+		px[lane] = positions[prev == SpringStore::NO_BODY ? springs.body[i] : prev].x;
+		py[lane] = positions[prev == SpringStore::NO_BODY ? springs.body[i] : prev].y;
+		hasPrev[lane] = prev == SpringStore::NO_BODY ? 0.0f : 1.0f;
+	}
+
+	const T zero = L::set(0.0f);
+	const T half = L::set(0.5f);
+	const T epsilon = L::set(b2_epsilon);
+
+	T bX = L::load(bx), bY = L::load(by);
+
+	// Linear component, body -> nextBody
+	T dX = L::sub(L::load(nx), bX);
+	T dY = L::sub(L::load(ny), bY);
+	T length = L::sqrt(L::add(L::mul(dX, dX), L::mul(dY, dY)));
+	T invLength = L::select(L::less(length, epsilon), zero, L::div(L::set(1.0f), length));
+
+	T force = L::mul(L::load(&springs.linearK[begin]), L::sub(length, L::load(&springs.restLength[begin])));
+	T linearScale = L::mul(L::mul(force, half), invLength);
+	T linearX = L::mul(linearScale, dX);
+	T linearY = L::mul(linearScale, dY);
+
+	// Angular component, diffVecPrev = body - prevBody, diffVecNext = body - nextBody = -d
+	T aX = L::sub(bX, L::load(px));
+	T aY = L::sub(bY, L::load(py));
+	T cX = L::sub(zero, dX);
+	T cY = L::sub(zero, dY);
+
+	T dot = L::add(L::mul(aX, cX), L::mul(aY, cY));
+	T det = L::sub(L::mul(aX, cY), L::mul(aY, cX));
+
+	T angle = approxAtan2<L>(det, dot);
+	angle = L::select(L::less(angle, zero), L::add(angle, L::set(2.0f * b2_pi)), angle);
+
+	T deltaAngle = L::add(L::sub(angle, L::load(&springs.restAngle[begin])), L::load(&springs.baseLineAngle[begin]));
+	T rotForce = L::mul(L::mul(L::load(&springs.rotK[begin]), deltaAngle), L::mul(half, L::load(hasPrev)));
+
+	T prevLength = L::sqrt(L::add(L::mul(aX, aX), L::mul(aY, aY)));
+	T invPrevLength = L::select(L::less(prevLength, epsilon), zero, L::div(L::set(1.0f), prevLength));
+
+	// Perpendiculars of both arms, scaled by the rotational force
+	T prevScale = L::mul(rotForce, invPrevLength);
+	T nextScale = L::mul(rotForce, invLength);
+	T prevForceX = L::mul(prevScale, aY);
+	T prevForceY = L::mul(prevScale, L::sub(zero, aX));
+	T nextForceX = L::mul(nextScale, L::sub(zero, cY));
+	T nextForceY = L::mul(nextScale, cX);
+
+	// Scatter, lanes can share bodies so this stays scalar
+	float32 lx[W], ly[W], pfx[W], pfy[W], nfx[W], nfy[W];
+	L::store(lx, linearX);
+	L::store(ly, linearY);
+	L::store(pfx, prevForceX);
+	L::store(pfy, prevForceY);
+	L::store(nfx, nextForceX);
+	L::store(nfy, nextForceY);
+
+	for (unsigned int lane = 0; lane < W; lane++) {
+		unsigned int i = begin + lane;
+		b2Vec2& bodyForce = forces[springs.body[i]];
+		b2Vec2& nextForce = forces[springs.nextBody[i]];
+
+		bodyForce.x += lx[lane] - pfx[lane] - nfx[lane];
+		bodyForce.y += ly[lane] - pfy[lane] - nfy[lane];
+		nextForce.x += nfx[lane] - lx[lane];
+		nextForce.y += nfy[lane] - ly[lane];
+
+		if (hasPrev[lane] != 0.0f) {
+			forces[springs.prevBody[i]].x += pfx[lane];
+			forces[springs.prevBody[i]].y += pfy[lane];
+		}
+	}
+}
+
+unsigned int getSpringKernelWidth()
+{
+	return SimdLanes::width;
+}
+
+void accumulateSpringForcesBatched(const SpringStore& springs, const b2Vec2* positions, b2Vec2* forces, unsigned int begin, unsigned int end)
+{
+	unsigned int i = begin;
+	for (; i + SimdLanes::width <= end; i += SimdLanes::width) {
+		springBatch<SimdLanes>(springs, positions, forces, i);
+	}
+	// Remainder that doesn't fill a whole batch
+	for (; i < end; i++) {
+		springBatch<ScalarLanes>(springs, positions, forces, i);
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <Box2D\Box2D.h>
+
+struct SpringStore;
+
+// Number of springs the batched force kernel handles at once
+// 8 when compiled with AVX2 (/arch:AVX2 or -mavx2), 4 with SSE2 (always on x64), otherwise 1 (plain scalar code)
+unsigned int getSpringKernelWidth();
+
+// Batched version of SpringStore::accumulateForces
+// Same forces, but computed for several springs at once in single precision, with approxAtan2 in place of atan2
+void accumulateSpringForcesBatched(const SpringStore& springs, const b2Vec2* positions, b2Vec2* forces, unsigned int begin, unsigned int end);
+
+// Polynomial atan2 used by the batched kernel, exposed for checking against std::atan2
+// Result is in [-pi, pi], absolute error is below 2e-6 radians
+float32 approxAtan2(float32 y, float32 x);
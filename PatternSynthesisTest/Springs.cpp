@@ -1,161 +1,434 @@
 #include "Springs.h"
+#include "SpringKernel.h"
+
+#include <cmath>
+#include <algorithm>
 
 static const float INVSCALE = 1.0f / 30.0f;
 
-Spring::Spring(b2Body* body, b2Body* nextBody, b2World* world) :
-	body(body), nextBody(nextBody)
-{
-	restLength = b2Distance(body->GetPosition(), nextBody->GetPosition());
-	
-}
+// Every spring line body is slowed down by this much, and network nodes the same
+static const float32 SECTION_LINEAR_DAMPING = 4.0f;
 
-void Spring::setPrevBody(b2Body* prevBody)
+void SpringStore::add(int32 prevBody, int32 body, int32 nextBody, const std::vector<b2Vec2>& positions)
 {
-	this->prevBody = prevBody;
-	b2Vec2 diffVecPrev = body->GetPosition() - prevBody->GetPosition();
-	b2Vec2 diffVecNext = body->GetPosition() - nextBody->GetPosition();
+	this->prevBody.push_back(prevBody);
+	this->body.push_back(body);
+	this->nextBody.push_back(nextBody);
 
-	float32 anglePrev = atan2(diffVecPrev.y, diffVecPrev.x);
-	float32 angleNext = atan2(diffVecNext.y, diffVecNext.x);
+	float32 baseLine = 0.0f;
+	if (prevBody != NO_BODY) {
+		b2Vec2 diffVecPrev = positions[body] - positions[prevBody];
+		b2Vec2 diffVecNext = positions[body] - positions[nextBody];
 
-	baseLineAngle = b2_pi - abs(anglePrev - angleNext) - b2_pi;
-	//std::cout << "Base line angle: " << baseLineAngle * RADTODEG << std::endl;
+		float32 anglePrev = atan2(diffVecPrev.y, diffVecPrev.x);
+		float32 angleNext = atan2(diffVecNext.y, diffVecNext.x);
+
+		baseLine = b2_pi - std::abs(anglePrev - angleNext) - b2_pi;
+	}
+
+	restAngle.push_back(10.0f * DEGTORAD); // For now, the rest angle doesn't need to be set (we need to know what the spring line is attached to first)
+	baseLineAngle.push_back(baseLine);
+	restLength.push_back(b2Distance(positions[body], positions[nextBody]));
+	linearK.push_back(20.0f);
+	rotK.push_back(20.0f);
 }
 
-void Spring::setRestAngle(float32 angle)
+void SpringStore::accumulateForces(const b2Vec2* positions, b2Vec2* forces, unsigned int begin, unsigned int end) const
 {
-	restAngle = angle;
+	for (unsigned int i = begin; i < end; i++) {
+		const b2Vec2 bodyPos = positions[body[i]];
+		const b2Vec2 nextPos = positions[nextBody[i]];
+
+		// Linear component, pulls body and nextBody together or pushes them apart based on distance
+		float32 distance = b2Distance(bodyPos, nextPos);
+		float32 force = linearK[i] * (distance - restLength[i]);
+
+		b2Vec2 diffVec = nextPos - bodyPos;
+		diffVec.Normalize();
+
+		forces[body[i]] += (force / 2.0f) * diffVec;
+		forces[nextBody[i]] += (force / 2.0f) * -diffVec;
+
+		if (prevBody[i] == NO_BODY) continue;
+
+		// Angular component, bends the line at body towards the rest angle
+		b2Vec2 diffVecPrev = bodyPos - positions[prevBody[i]];
+		b2Vec2 diffVecNext = bodyPos - nextPos;
+
+		float64 dot = diffVecPrev.x * diffVecNext.x + diffVecPrev.y * diffVecNext.y;
+		float64 det = diffVecPrev.x * diffVecNext.y - diffVecPrev.y * diffVecNext.x;
+
+		float64 angle = atan2(det, dot);
+		if (angle < 0) angle += 2 * b2_pi;
+
+		float64 deltaAngle = angle - restAngle[i] + baseLineAngle[i];
+
+		float64 rotForce = rotK[i] * deltaAngle;
+
+		b2Vec2 prevBodyForceVec = b2Vec2(diffVecPrev.y, -diffVecPrev.x);
+		b2Vec2 nextBodyForceVec = b2Vec2(-diffVecNext.y, diffVecNext.x);
+		prevBodyForceVec.Normalize();
+		nextBodyForceVec.Normalize();
+
+		forces[prevBody[i]] += (rotForce / 2.0f) * prevBodyForceVec;
+		forces[nextBody[i]] += (rotForce / 2.0f) * nextBodyForceVec;
+
+		forces[body[i]] += (rotForce / 2.0f) * -prevBodyForceVec;
+		forces[body[i]] += (rotForce / 2.0f) * -nextBodyForceVec;
+	}
 }
 
-void Spring::updateForces()
+void SpringStore::measureResiduals(const b2Vec2* positions, unsigned int begin, unsigned int end, float32& maxLength, float32& maxAngle) const
 {
-	float32 distance = b2Distance(body->GetPosition(), nextBody->GetPosition());
-	float32 force = linearK * (distance - restLength);
-	
-	b2Vec2 diffVec = nextBody->GetPosition() - body->GetPosition();
-	diffVec.Normalize();
+	for (unsigned int i = begin; i < end; i++) {
+		const b2Vec2 bodyPos = positions[body[i]];
+		const b2Vec2 nextPos = positions[nextBody[i]];
 
-	body->ApplyForceToCenter((force / 2.0f) * diffVec, true);
-	nextBody->ApplyForceToCenter((force / 2.0f) * -diffVec, true);
-	
-	if (!prevBody) return;
-	
-	b2Vec2 diffVecPrev = body->GetPosition() - prevBody->GetPosition();
-	b2Vec2 diffVecNext = body->GetPosition() - nextBody->GetPosition();
+		maxLength = b2Max(maxLength, std::abs(b2Distance(bodyPos, nextPos) - restLength[i]));
 
-	float64 anglePrev = atan2(diffVecPrev.y, diffVecPrev.x);
-	float64 angleNext = atan2(diffVecNext.y, diffVecNext.x);
-	
-	float64 dot = diffVecPrev.x * diffVecNext.x + diffVecPrev.y * diffVecNext.y;
-	float64 det = diffVecPrev.x * diffVecNext.y - diffVecPrev.y * diffVecNext.x;
+		if (prevBody[i] == NO_BODY) continue;
 
-	float64 angle = atan2(det, dot);
-	if (angle < 0) angle += 2 * b2_pi;
+		// Same angle as accumulateForces
+		b2Vec2 diffVecPrev = bodyPos - positions[prevBody[i]];
+		b2Vec2 diffVecNext = bodyPos - nextPos;
 
-	float64 deltaAngle = angle - restAngle + baseLineAngle;
+		float64 dot = diffVecPrev.x * diffVecNext.x + diffVecPrev.y * diffVecNext.y;
+		float64 det = diffVecPrev.x * diffVecNext.y - diffVecPrev.y * diffVecNext.x;
 
-	float64 rotForce = rotK * deltaAngle;
+		float64 angle = atan2(det, dot);
+		if (angle < 0) angle += 2 * b2_pi;
 
-	//std::cout << "Inner Angle: " << angle * RADTODEG << " Angle Prev: " << anglePrev * RADTODEG << " Angle Next: " << angleNext * RADTODEG << std::endl;
+		maxAngle = b2Max(maxAngle, (float32)std::abs(angle - restAngle[i] + baseLineAngle[i]));
+	}
+}
 
+float32 SolverStats::averageVelocityIterations() const
+{
+	return worldSteps > 0 ? (float32)velocityIterations / worldSteps : 0.0f;
+}
 
-	b2Vec2 prevBodyForceVec = b2Vec2(diffVecPrev.y, -diffVecPrev.x);
-	b2Vec2 nextBodyForceVec = b2Vec2(-diffVecNext.y, diffVecNext.x);
-	prevBodyForceVec.Normalize();
-	nextBodyForceVec.Normalize();
-	
-	prevBody->ApplyForceToCenter((rotForce / 2.0f) * prevBodyForceVec, true);
-	nextBody->ApplyForceToCenter((rotForce / 2.0f) * nextBodyForceVec, true);
-	
-	body->ApplyForceToCenter((rotForce / 2.0f) * -prevBodyForceVec, true);
-	body->ApplyForceToCenter((rotForce / 2.0f) * -nextBodyForceVec, true);
+float32 SolverStats::averagePositionIterations() const
+{
+	return worldSteps > 0 ? (float32)positionIterations / worldSteps : 0.0f;
+}
 
-	
+bool ConvergenceCriteria::isEnabled() const
+{
+	return kineticEnergy > 0.0f || maxSpeed > 0.0f || lengthResidual > 0.0f || angleResidual > 0.0f;
+}
 
+bool ConvergenceStats::meets(const ConvergenceCriteria& criteria) const
+{
+	if (!criteria.isEnabled()) return false;
+	if (criteria.kineticEnergy > 0.0f && kineticEnergy > criteria.kineticEnergy) return false;
+	if (criteria.maxSpeed > 0.0f && maxSpeed > criteria.maxSpeed) return false;
+	if (criteria.lengthResidual > 0.0f && lengthResidual > criteria.lengthResidual) return false;
+	if (criteria.angleResidual > 0.0f && angleResidual > criteria.angleResidual) return false;
+	return true;
 }
 
-SpringLine::SpringLine(b2Vec2 startPoint, b2Vec2 endPoint, std::vector<Spring*> springs, RASF restAngleFunc) :
+SpringLine::SpringLine(b2Vec2 startPoint, b2Vec2 endPoint, unsigned int firstSpring, unsigned int numSprings, RASFSettings rasf, Random rng) :
+	firstSpring(firstSpring), numSprings(numSprings),
 	startPoint(startPoint), endPoint(endPoint),
-	springs(springs),
-	restAngleFunc(restAngleFunc)
+	rasf(rasf), rng(rng)
 {
 	b2Vec2 diffVector = endPoint - startPoint;
 	initialAngle = atan2(diffVector.y, diffVector.x);
 }
 
+// Grid cell of a spring line end point, used to find end points that are close together
+struct EndPointCell {
+	int32 x, y;
+	unsigned int line;
+
+	bool operator<(const EndPointCell& other) const {
+		if (x != other.x) return x < other.x;
+		if (y != other.y) return y < other.y;
+		return line < other.line;
+	}
+};
+
 // Goes through spring lines and attaches them together
 void SpringWorld::connectSpringLines() {
 	float32	minDistance = 0.0001; // TODO: maybe test this
-	for (auto s1 = springLines.begin(); s1 != springLines.end(); s1++) {
-		for (auto s2 = s1 + 1; s2 != springLines.end(); s2++) {
 
-			if (s1 == s2) continue;
-			
-			// TODO: This is ugly and error prone
+	// Bucket every end point into a grid sorted by cell. Cells are twice minDistance wide,
+	// so two points within minDistance of each other are always in the same or neighbouring cells
+	float32 invCellSize = 1.0f / (2.0f * minDistance);
+	std::vector<EndPointCell> cells;
+	cells.reserve(springLines.size() * 2);
+	for (unsigned int i = 0; i < springLines.size(); i++) {
+		for (const b2Vec2& p : { springLines[i].startPoint, springLines[i].endPoint }) {
+			cells.push_back({ (int32)std::floor(p.x * invCellSize), (int32)std::floor(p.y * invCellSize), i });
+		}
+	}
+	std::sort(cells.begin(), cells.end());
+
+	// Pairs of lines with end points in neighbouring cells, these are the only ones that can be connected
+	std::vector<std::pair<unsigned int, unsigned int>> candidates;
+	for (const EndPointCell& cell : cells) {
+		for (int32 dx = -1; dx <= 1; dx++) {
+			for (int32 dy = -1; dy <= 1; dy++) {
+				EndPointCell first = { cell.x + dx, cell.y + dy, 0 };
+				for (auto it = std::lower_bound(cells.begin(), cells.end(), first); it != cells.end() && it->x == first.x && it->y == first.y; it++) {
+					if (cell.line < it->line) candidates.push_back(std::make_pair(cell.line, it->line));
+				}
+			}
+		}
+	}
 
-			b2RevoluteJointDef jointDef;
-			jointDef.collideConnected = false;
+	// Same order as checking every pair of lines, so joints and end angles come out in the same order too
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
-			if (b2Distance((*s1)->startPoint, (*s2)->startPoint) <= minDistance) {
-				jointDef.bodyA = (*s1)->startBody;
-				jointDef.bodyB = (*s2)->startBody;
-				world->CreateJoint(&jointDef);
-				
-				float32 s1Angle = clampAngle((*s2)->initialAngle - (*s1)->initialAngle);
-				float32 s2Angle = clampAngle((*s1)->initialAngle - (*s2)->initialAngle);
-				(*s1)->startAngles.push_back(s1Angle);
-				(*s2)->startAngles.push_back(s2Angle);
-			}
-			if (b2Distance((*s1)->startPoint, (*s2)->endPoint) <= minDistance) {
-				jointDef.bodyA = (*s1)->startBody;
-				jointDef.bodyB = (*s2)->endBody;
-				world->CreateJoint(&jointDef);
-				
-				float32 s1Angle = clampAngle((*s2)->initialAngle - (*s1)->initialAngle);
-				float32 s2Angle = clampAngle((*s1)->initialAngle - (*s2)->initialAngle);
-				(*s1)->startAngles.push_back(s1Angle);
-				(*s2)->endAngles.push_back(s2Angle);
-			}
-			if (b2Distance((*s1)->endPoint, (*s2)->startPoint) <= minDistance) {
-				jointDef.bodyA = (*s1)->endBody;
-				jointDef.bodyB = (*s2)->startBody;
-				world->CreateJoint(&jointDef);
-				
-				float32 s1Angle = clampAngle((*s2)->initialAngle - (*s1)->initialAngle);
-				float32 s2Angle = clampAngle((*s1)->initialAngle - (*s2)->initialAngle);
-				(*s1)->endAngles.push_back(s1Angle);
-				(*s2)->startAngles.push_back(s2Angle);
-			}
-			if (b2Distance((*s1)->endPoint, (*s2)->endPoint) <= minDistance) {
-				jointDef.bodyA = (*s1)->endBody;
-				jointDef.bodyB = (*s2)->endBody;
-				world->CreateJoint(&jointDef);
-				
-				float32 s1Angle = clampAngle((*s2)->initialAngle - (*s1)->initialAngle);
-				float32 s2Angle = clampAngle((*s1)->initialAngle - (*s2)->initialAngle);
-				(*s1)->endAngles.push_back(s1Angle);
-				(*s2)->endAngles.push_back(s2Angle);
+	for (const std::pair<unsigned int, unsigned int>& candidate : candidates) {
+		SpringLine* s1 = &springLines[candidate.first];
+		SpringLine* s2 = &springLines[candidate.second];
+
+		if (b2Distance(s1->startPoint, s2->startPoint) <= minDistance) joinSpringLines(candidate.first, false, candidate.second, false);
+		if (b2Distance(s1->startPoint, s2->endPoint) <= minDistance) joinSpringLines(candidate.first, false, candidate.second, true);
+		if (b2Distance(s1->endPoint, s2->startPoint) <= minDistance) joinSpringLines(candidate.first, true, candidate.second, false);
+		if (b2Distance(s1->endPoint, s2->endPoint) <= minDistance) joinSpringLines(candidate.first, true, candidate.second, true);
+	}
+}
+
+bool LineJoin::operator<(const LineJoin& other) const
+{
+	if (s1 != other.s1) return s1 < other.s1;
+	if (s2 != other.s2) return s2 < other.s2;
+	if (s1End != other.s1End) return s1End < other.s1End;
+	return s2End < other.s2End;
+}
+
+void SpringWorld::connectSpringLines(const VoronoiGraph& graph, unsigned int firstLine)
+{
+	// Every pair of lines touching the same vertex gets joined, as the same checks connectSpringLines() makes
+	std::vector<LineJoin> joins;
+	for (unsigned int v = 0; v < graph.vertices.size(); v++) {
+		for (unsigned int i = graph.incidenceStart[v]; i < graph.incidenceStart[v + 1]; i++) {
+			for (unsigned int j = i + 1; j < graph.incidenceStart[v + 1]; j++) {
+				unsigned int e1 = b2Min(graph.incidences[i].edge, graph.incidences[j].edge);
+				unsigned int e2 = b2Max(graph.incidences[i].edge, graph.incidences[j].edge);
+				if (e1 == e2) continue; // Zero length edge touching its own vertex twice
+				joins.push_back({ firstLine + e1, firstLine + e2, graph.edges[e1].a != v, graph.edges[e2].a != v });
 			}
+		}
+	}
+
+	// Same order connectSpringLines() would join them in, so patterns come out exactly the same
+	std::sort(joins.begin(), joins.end());
+	for (const LineJoin& join : joins) {
+		joinSpringLines(join.s1, join.s1End, join.s2, join.s2End);
+	}
+}
+
+void SpringWorld::joinSpringLines(unsigned int s1, bool s1End, unsigned int s2, bool s2End)
+{
+	SpringLine& line1 = springLines[s1];
+	SpringLine& line2 = springLines[s2];
+
+	pendingJoins.push_back({ s1, s2, s1End, s2End });
+
+	float32 s1Angle = clampAngle(line2.initialAngle - line1.initialAngle);
+	float32 s2Angle = clampAngle(line1.initialAngle - line2.initialAngle);
+	(s1End ? line1.endAngles : line1.startAngles).push_back(s1Angle);
+	(s2End ? line2.endAngles : line2.startAngles).push_back(s2Angle);
+}
+
+void SpringWorld::createJoint(const LineJoin& join)
+{
+	const SpringLine& s1 = springLines[join.s1];
+	const SpringLine& s2 = springLines[join.s2];
+
+	b2RevoluteJointDef jointDef;
+	jointDef.collideConnected = false;
+	jointDef.bodyA = bodies[join.s1End ? s1.endBody : s1.startBody];
+	jointDef.bodyB = bodies[join.s2End ? s2.endBody : s2.startBody];
+	if (stepSettings.mode == STEP_MODE_SUBSTEP) {
+		jointDef.frequencyHz = stepSettings.jointHertz;
+		jointDef.dampingRatio = stepSettings.jointDampingRatio;
+	}
+	world->CreateJoint(&jointDef);
+}
 
+// Picks which of a line's planned bodies (0 to angles.size()) to keep, angles[i] being the rest angle at planned body i
+// A spring keeps growing over the next planned body until the rest angles of the bodies it skips would bend the line by more than maxBend
+static void pickBodies(const std::vector<float32>& angles, const SubdivisionSettings& settings, std::vector<unsigned int>& kept)
+{
+	unsigned int numSegments = (unsigned int)angles.size();
+	unsigned int maxMerge = b2Max(settings.maxMerge, 1u);
+
+	kept.clear();
+	kept.push_back(0);
+	unsigned int start = 0;
+	while (start < numSegments) {
+		unsigned int end = start + 1;
+		float32 bend = 0.0f;
+		while (end < numSegments && end - start < maxMerge) {
+			bend += std::abs(angles[end]);
+			if (bend > settings.maxBend) break;
+			end++;
+		}
+		kept.push_back(end);
+		start = end;
+	}
+}
+
+// Rest angles of the springs between kept bodies. Each dropped body's rest angle is added to the nearest kept body
+// that has one (not the line's first or last), so the line turns by the same amount in total
+static void mergeRestAngles(const std::vector<float32>& angles, const std::vector<unsigned int>& kept, float32* restAngles)
+{
+	unsigned int numSprings = (unsigned int)kept.size() - 1;
+	for (unsigned int j = 0; j < numSprings; j++) {
+		restAngles[j] = angles[kept[j]]; // The first spring has no previous body, its rest angle is unused
+	}
+
+	if (numSprings == 1) return; // Straight enough to be one spring, nothing to bend at
+	for (unsigned int j = 0; j < numSprings; j++) {
+		for (unsigned int i = kept[j] + 1; i < kept[j + 1]; i++) {
+			bool toStart = i - kept[j] <= kept[j + 1] - i;
+			if (j == 0) toStart = false;
+			else if (j + 1 == numSprings) toStart = true;
+			restAngles[toStart ? j : j + 1] += angles[i];
 		}
 	}
 }
 
- void SpringWorld::initRestAngles() {
-	for (SpringLine* s : springLines) {
-			
-		for (int i = 0; i < s->springs.size(); i++) {
+void SpringWorld::subdivideSpringLines()
+{
+	for (SpringLine& s : springLines) {
+		if (!s.adaptive || s.startBody != SpringStore::NO_BODY) continue;
+
+		// Same rest angles the line would get with every planned spring
+		plannedAngles.resize(s.plannedSegments);
+		RASFLine line = { s.startAngles, s.endAngles, s.plannedSegments, s.rng };
+		fillRestAngles(s.rasf, line, plannedAngles.data());
+
+		pickBodies(plannedAngles, subdivision, keptBodies);
+
+		s.firstSpring = springs.size();
+		createLineBodies(s.startPoint, s.endPoint, s.plannedSegments, keptBodies, s.dynamic);
+		s.numSprings = springs.size() - s.firstSpring;
+		s.startBody = (int32)(bodies.size() - keptBodies.size());
+		s.endBody = (int32)bodies.size() - 1;
+
+		mergeRestAngles(plannedAngles, keptBodies, &springs.restAngle[s.firstSpring]);
+	}
+}
+
+void SpringWorld::createBodies()
+{
+	if (springSolver == SPRING_SOLVER_NETWORK) {
+		createNetworkNodes();
+		return;
+	}
+
+	// Queued bodies are always the last ones
+	unsigned int firstBody = (unsigned int)(bodies.size() - bodyDefs.size());
+	world->CreateBodies(bodyDefs.data(), (int32)bodyDefs.size(), nullptr, bodies.data() + firstBody);
+	bodyDefs.clear();
+
+	b2RevoluteJointDef jointDef;
+	world->ReserveJoints(&jointDef, (int32)pendingJoins.size());
+	for (const LineJoin& join : pendingJoins) {
+		createJoint(join);
+	}
+	pendingJoins.clear();
+}
 
-			float32 t = (float32)i / (float32)s->springs.size(); // How far along the spring line, from 0 to 1 
+void SpringWorld::createNetworkNodes()
+{
+	unsigned int firstBody = (unsigned int)(bodies.size() - bodyDefs.size());
+
+	// Joined line ends are grouped (union-find, every group named by its lowest body) and each group becomes one node
+	std::vector<int32> junction(bodies.size());
+	for (unsigned int i = 0; i < bodies.size(); i++) junction[i] = i;
+	auto findJunction = [&junction](int32 i) {
+		while (junction[i] != i) i = junction[i] = junction[junction[i]];
+		return i;
+	};
+	for (const LineJoin& join : pendingJoins) {
+		const SpringLine& s1 = springLines[join.s1];
+		const SpringLine& s2 = springLines[join.s2];
+		int32 a = findJunction(join.s1End ? s1.endBody : s1.startBody);
+		int32 b = findJunction(join.s2End ? s2.endBody : s2.startBody);
+		junction[b2Max(a, b)] = b2Min(a, b);
+	}
+	pendingJoins.clear();
+
+	// A group is as heavy as all of its bodies, and pinned if any of them is static
+	std::vector<float32> mass(bodies.size(), 0.0f);
+	for (unsigned int i = firstBody; i < bodies.size(); i++) {
+		const b2BodyDef& def = bodyDefs[i - firstBody];
+		float32& groupMass = mass[findJunction(i)];
+		if (def.type != b2_dynamicBody) groupMass = -1.0f;
+		else if (groupMass >= 0.0f) groupMass += def.massData.mass;
+	}
+
+	b2SpringNetworkDef networkDef;
+	networkDef.damping = SECTION_LINEAR_DAMPING;
+	network.Initialize(&networkDef);
+	network.Reserve((int32)bodyDefs.size(), 0, 0);
+
+	bodyNodes.resize(bodies.size());
+	for (unsigned int i = firstBody; i < bodies.size(); i++) {
+		int32 group = findJunction(i);
+		if (group == (int32)i) bodyNodes[i] = network.AddNode(bodyDefs[i - firstBody].position, b2Max(mass[i], 0.0f));
+		else bodyNodes[i] = bodyNodes[group];
+	}
+	bodyDefs.clear();
+}
 
-			s->springs[i]->restAngle = s->restAngleFunc(s->startAngles, s->endAngles, t, s->springs.size());
+void SpringWorld::initRestAngles() {
+	for (SpringLine& s : springLines) {
+		if (s.adaptive) continue; // Set by subdivideSpringLines
+		RASFLine line = { s.startAngles, s.endAngles, s.numSprings, s.rng };
+		fillRestAngles(s.rasf, line, &springs.restAngle[s.firstSpring]);
+	}
+}
+
+void SpringWorld::createSpringJoints()
+{
+	if (springSolver == SPRING_SOLVER_FORCES) return;
+
+	b2SpringJointDef jointDef;
+	if (springSolver == SPRING_SOLVER_JOINTS) world->ReserveJoints(&jointDef, (int32)springs.size());
+	else network.Reserve(0, (int32)springs.size(), (int32)springs.size());
+
+	for (unsigned int i = 0; i < springs.size(); i++) {
+		// The force kernel pushes each end with half the spring force, and the outer bodies of a corner with half of
+		// rotK * angle no matter how long the arms are. A joint's corner pushes them with angularStiffness * angle / arm length
+		float32 stiffness = springStiffness * springs.linearK[i] / 2.0f;
+		float32 angle = springs.restAngle[i] - springs.baseLineAngle[i];
+		float32 angularStiffness = springStiffness * springs.rotK[i] * springs.restLength[i] / 2.0f;
+
+		if (springSolver == SPRING_SOLVER_NETWORK) {
+			// Compliance is inverse stiffness
+			int32 node = bodyNodes[springs.body[i]];
+			network.AddDistance(node, bodyNodes[springs.nextBody[i]], springs.restLength[i], 1.0f / stiffness);
+			if (springs.prevBody[i] != SpringStore::NO_BODY) {
+				network.AddBend(bodyNodes[springs.prevBody[i]], node, bodyNodes[springs.nextBody[i]], angle, 1.0f / angularStiffness);
+			}
+			continue;
 		}
+
+		jointDef.bodyA = bodies[springs.body[i]];
+		jointDef.bodyB = bodies[springs.nextBody[i]];
+		jointDef.bodyC = springs.prevBody[i] == SpringStore::NO_BODY ? nullptr : bodies[springs.prevBody[i]];
+		jointDef.length = springs.restLength[i];
+		jointDef.stiffness = stiffness;
+		jointDef.angle = angle;
+		jointDef.angularStiffness = angularStiffness;
+		world->CreateJoint(&jointDef);
 	}
 }
 
 void SpringWorld::initSpringWorld() {
 	connectSpringLines();
+	subdivideSpringLines();
+	createBodies();
 	initRestAngles();
+	createSpringJoints();
 }
 
 b2World* SpringWorld::getWorld()
@@ -163,102 +436,334 @@ b2World* SpringWorld::getWorld()
 	return world;
 }
 
+Random& SpringWorld::getRandom()
+{
+	return rng;
+}
+
+void SpringWorld::setForceKernel(FORCE_KERNEL kernel)
+{
+	forceKernel = kernel;
+}
+
+SpringWorld::~SpringWorld()
+{
+	// The world can outlive us, don't leave it pointing at our executor
+	if (threadPool) world->SetTaskExecutor(nullptr);
+}
+
+void SpringWorld::setThreadPool(ThreadPool* pool)
+{
+	threadPool = pool;
+	taskExecutor.setThreadPool(pool);
+	// Islands of a spring pattern are small (lines are only jointed at their ends), so parallel island solving pays off
+	world->SetTaskExecutor(pool && pool->getThreadCount() > 1 ? &taskExecutor : nullptr);
+}
+
+ThreadPool* SpringWorld::getThreadPool() const
+{
+	return threadPool;
+}
+
+void SpringWorld::setConvergenceCriteria(const ConvergenceCriteria& criteria)
+{
+	convergenceCriteria = criteria;
+	converged = false;
+}
+
+bool SpringWorld::hasConverged() const
+{
+	return converged;
+}
+
+unsigned int SpringWorld::getStepCount() const
+{
+	return stepCount;
+}
+
+ConvergenceStats SpringWorld::measureConvergence()
+{
+	ConvergenceStats stats;
+	float32 maxSpeedSquared = 0.0f;
+	if (springSolver == SPRING_SOLVER_NETWORK) {
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			positions[i] = getBodyPosition(i);
+		}
+		for (int32 i = 0; i < network.GetNodeCount(); i++) {
+			float32 speedSquared = network.GetVelocities()[i].LengthSquared();
+			stats.kineticEnergy += 0.5f * network.GetMass(i) * speedSquared;
+			maxSpeedSquared = b2Max(maxSpeedSquared, speedSquared);
+		}
+	}
+	else {
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			const b2Body* body = bodies[i];
+			positions[i] = body->GetPosition();
+
+			float32 speedSquared = body->GetLinearVelocity().LengthSquared();
+			float32 angularVelocity = body->GetAngularVelocity();
+			stats.kineticEnergy += 0.5f * (body->GetMass() * speedSquared + body->GetInertia() * angularVelocity * angularVelocity);
+			maxSpeedSquared = b2Max(maxSpeedSquared, speedSquared);
+		}
+	}
+	stats.maxSpeed = std::sqrt(maxSpeedSquared);
+
+	springs.measureResiduals(positions.data(), 0, springs.size(), stats.lengthResidual, stats.angleResidual);
+	return stats;
+}
+
+void SpringWorld::setSleeping(bool enabled, float32 wakeForce)
+{
+	sleeping = enabled;
+	wakeForceSquared = wakeForce * wakeForce;
+}
+
+void SpringWorld::applyForce(unsigned int i)
+{
+	// Applying a force without waking is ignored by sleeping bodies, so they stay put until pushed hard enough
+	bool wake = !sleeping || forces[i].LengthSquared() > wakeForceSquared;
+	bodies[i]->ApplyForceToCenter(forces[i], wake);
+}
+
+void SpringWorld::accumulateForces(unsigned int begin, unsigned int end)
+{
+	if (forceKernel == FORCE_KERNEL_BATCHED) {
+		accumulateSpringForcesBatched(springs, positions.data(), forces.data(), begin, end);
+	}
+	else {
+		springs.accumulateForces(positions.data(), forces.data(), begin, end);
+	}
+}
+
+// Below this many springs waking the pool costs more than the force pass itself
+static const unsigned int PARALLEL_MIN_SPRINGS = 4096;
+
+// Springs per chunk of the force pass, whole SIMD batches. Fixed rather than picked from the thread count,
+// so every body sums its forces in the same order however many threads there are and a seed gives the same pattern anywhere
+static const unsigned int SPRING_CHUNK = 512;
+
+void SpringWorld::updateForcesParallel()
+{
+	// Springs are cut into chunks, many per thread so uneven chunks still balance
+	// Lines never share bodies, and inside a line spring i only touches bodies i - 1, i and i + 1,
+	// so two chunks can only touch the same body if they are next to each other (and the cut is inside a line).
+	// Running even chunks then odd chunks (a two colouring of the chunks) means no two chunks running at once share a body
+	unsigned int numChunks = (springs.size() + SPRING_CHUNK - 1) / SPRING_CHUNK;
+	unsigned int bodyChunk = ((unsigned int)bodies.size() + numChunks - 1) / numChunks;
+
+	threadPool->parallelFor(numChunks, [this, bodyChunk](unsigned int chunk, unsigned int) {
+		unsigned int end = b2Min((chunk + 1) * bodyChunk, (unsigned int)bodies.size());
+		for (unsigned int i = chunk * bodyChunk; i < end; i++) {
+			positions[i] = bodies[i]->GetPosition();
+			forces[i].SetZero();
+		}
+	});
+
+	for (unsigned int colour = 0; colour < 2; colour++) {
+		threadPool->parallelFor((numChunks + 1 - colour) / 2, [this, colour](unsigned int i, unsigned int) {
+			unsigned int chunk = i * 2 + colour;
+			accumulateForces(chunk * SPRING_CHUNK, b2Min((chunk + 1) * SPRING_CHUNK, springs.size()));
+		});
+	}
+
+	threadPool->parallelFor(numChunks, [this, bodyChunk](unsigned int chunk, unsigned int) {
+		unsigned int end = b2Min((chunk + 1) * bodyChunk, (unsigned int)bodies.size());
+		for (unsigned int i = chunk * bodyChunk; i < end; i++) {
+			applyForce(i);
+		}
+	});
+}
+
+void SpringWorld::applySpringForces()
+{
+	if (threadPool && threadPool->getThreadCount() > 1 && springs.size() >= PARALLEL_MIN_SPRINGS) {
+		updateForcesParallel();
+	}
+	else {
+		// Gather body positions once so the spring pass only touches contiguous arrays
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			positions[i] = bodies[i]->GetPosition();
+			forces[i].SetZero();
+		}
+
+		// Same chunk order as updateForcesParallel, so both sum forces identically
+		for (unsigned int colour = 0; colour < 2; colour++) {
+			for (unsigned int begin = colour * SPRING_CHUNK; begin < springs.size(); begin += 2 * SPRING_CHUNK) {
+				accumulateForces(begin, b2Min(begin + SPRING_CHUNK, springs.size()));
+			}
+		}
+
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			applyForce(i);
+		}
+	}
+}
+
+void SpringWorld::stepWorld(float32 timeStep, int32 velocityIterations, int32 positionIterations)
+{
+	world->Step(timeStep, velocityIterations, positionIterations);
+
+	const b2Profile& profile = world->GetProfile();
+	solverStats.worldSteps++;
+	solverStats.velocityIterations += profile.maxVelocityIterations;
+	solverStats.maxVelocityIterations = b2Max(solverStats.maxVelocityIterations, (unsigned int)profile.maxVelocityIterations);
+	solverStats.positionIterations += profile.maxPositionIterations;
+	solverStats.maxPositionIterations = b2Max(solverStats.maxPositionIterations, (unsigned int)profile.maxPositionIterations);
+}
+
 // Takes physics timestep
 void SpringWorld::update(float32 timeStep) {
-	for (SpringLine* sl : springLines) {
-		for (Spring* s : sl->springs) {
-			s->updateForces();
+	if (converged) return;
+
+	if (springSolver == SPRING_SOLVER_NETWORK) {
+		unsigned int substeps = stepSettings.mode == STEP_MODE_SUBSTEP ? b2Max(stepSettings.substeps, 1u) : 1;
+		for (unsigned int i = 0; i < substeps; i++) {
+			network.Step(timeStep / substeps, stepSettings.networkIterations);
+		}
+	}
+	else if (stepSettings.mode == STEP_MODE_SUBSTEP) {
+		// The spring forces are explicit, recomputing them every sub-step keeps them from fighting the joints for a whole step
+		unsigned int substeps = b2Max(stepSettings.substeps, 1u);
+		for (unsigned int i = 0; i < substeps; i++) {
+			if (springSolver == SPRING_SOLVER_FORCES) applySpringForces();
+			stepWorld(timeStep / substeps, stepSettings.substepIterations, 1);
 		}
 	}
-	world->Step(timeStep, 80, 30); // Hard-coded position/velocity iterations
+	else {
+		if (springSolver == SPRING_SOLVER_FORCES) applySpringForces();
+		stepWorld(timeStep, stepSettings.velocityIterations, stepSettings.positionIterations);
+	}
+	stepCount++;
+
+	if (convergenceCriteria.isEnabled() && stepCount % b2Max(convergenceCriteria.checkInterval, 1u) == 0) {
+		converged = measureConvergence().meets(convergenceCriteria);
+	}
 }
 
-void SpringWorld::createSpringLine(b2Vec2 from, b2Vec2 to, unsigned int numSegments, RASF restAngleFunc, bool dynamic) {
-	// TODO: this function is heavily coupled to box2d
+void SpringWorld::setSubdivision(const SubdivisionSettings& settings)
+{
+	subdivision = settings;
+}
+
+void SpringWorld::setStepSettings(const StepSettings& settings)
+{
+	stepSettings = settings;
+	world->SetVelocityTolerance(settings.velocityTolerance);
+}
+
+const StepSettings& SpringWorld::getStepSettings() const
+{
+	return stepSettings;
+}
+
+const SolverStats& SpringWorld::getSolverStats() const
+{
+	return solverStats;
+}
+
+void SpringWorld::setSpringSolver(SPRING_SOLVER solver, float32 stiffness)
+{
+	springSolver = solver;
+	springStiffness = stiffness;
+}
+
+unsigned int SpringWorld::getBodyCount() const
+{
+	return springSolver == SPRING_SOLVER_NETWORK ? (unsigned int)network.GetNodeCount() : (unsigned int)bodies.size();
+}
+
+void SpringWorld::createSpringLine(b2Vec2 from, b2Vec2 to, unsigned int numSegments, RASFSettings rasf, bool dynamic) {
+	if (subdivision.enabled) {
+		// Bodies come later, once the line's rest angles are known (see subdivideSpringLines)
+		SpringLine line(from, to, 0, 0, rasf, rng.split());
+		line.adaptive = true;
+		line.dynamic = dynamic;
+		line.plannedSegments = numSegments;
+		springLines.push_back(line);
+		return;
+	}
+
+	unsigned int firstSpring = springs.size();
 
-	std::vector<Spring*> springs;
+	keptBodies.clear();
+	for (unsigned int i = 0; i < numSegments + 1; i++) keptBodies.push_back(i);
+	createLineBodies(from, to, numSegments, keptBodies, dynamic);
+
+	SpringLine line(from, to, firstSpring, springs.size() - firstSpring, rasf, rng.split());
+	line.startBody = (int32)(bodies.size() - (numSegments + 1));
+	line.endBody = (int32)bodies.size() - 1;
+
+	springLines.push_back(line);
+}
+
+void SpringWorld::createLineBodies(b2Vec2 from, b2Vec2 to, unsigned int numSegments, const std::vector<unsigned int>& kept, bool dynamic)
+{
+	// TODO: this function is heavily coupled to box2d
 
 	b2Vec2 diffVector = to - from;
-	float32 lineLength = diffVector.Length();
-	float32 segmentLength = lineLength / (float32)numSegments;
 
 	float32 lineAngle = atan2(diffVector.y, diffVector.x); // In radians
 
 	b2BodyDef sectionBodyDef;
 
 	if (dynamic) sectionBodyDef.type = b2_dynamicBody;
+
+	// Sections never collide with anything, so instead of a fixture (and a broad-phase proxy to keep up to date every step)
+	// they only get the mass of one, a 0.3m box with a density of 1
+	b2PolygonShape sectionShape;
+	sectionShape.SetAsBox(0.15f, 0.15f, b2Vec2(0.0f, 0.0f), 0.0f); // SetAsBox uses half-widths, so / 2.0f
+	sectionShape.ComputeMass(&sectionBodyDef.massData, 1.0f);
 	
 	sectionBodyDef.angularDamping = 2.0f; // TODO: May change this
-	sectionBodyDef.linearDamping = 4.0f; // TODO: and this
+	sectionBodyDef.linearDamping = SECTION_LINEAR_DAMPING; // TODO: and this
 
-	b2Body* firstBody = nullptr;
-	b2Body* lastBody = nullptr;
+	int32 prevPrevSpringBody = SpringStore::NO_BODY;
+	int32 prevSpringBody = SpringStore::NO_BODY;
 
-	b2Body* prevPrevSpringBody = nullptr;
-	b2Body* prevSpringBody = nullptr;
-
-	for (unsigned int i = 0; i < numSegments + 1; i++) {
+	for (unsigned int i : kept) {
 
 		b2Vec2 bodyPos = from + (((float32)i / (float32)numSegments) * diffVector);
 
 		sectionBodyDef.position.Set(bodyPos.x, bodyPos.y);
 		sectionBodyDef.angle = lineAngle;
 
-		b2Body* springBody = world->CreateBody(&sectionBodyDef);
-
-		b2PolygonShape sectionShape;
-		sectionShape.SetAsBox(0.15f, 0.15f, b2Vec2(0.0f, 0.0f), 0.0f); // SetAsBox uses half-widths, so / 2.0f
-
-		b2FixtureDef sectionFixtureDef;
-		sectionFixtureDef.shape = &sectionShape;
-		sectionFixtureDef.density = 1.0f;
-		sectionFixtureDef.filter.categoryBits = 0x0002; // Sections can never interact with other sections
-		sectionFixtureDef.filter.maskBits = 0x0004;
-
-		springBody->CreateFixture(&sectionFixtureDef);
+		// The body itself is created later, along with every other queued body (see createBodies)
+		bodyDefs.push_back(sectionBodyDef);
 
-		if (i == 0) firstBody = springBody;
+		int32 springBodyIndex = (int32)bodies.size();
+		bodies.push_back(nullptr);
+		positions.push_back(sectionBodyDef.position);
+		forces.push_back(b2Vec2_zero);
 
-		if (prevSpringBody) {
-			Spring* s = new Spring(prevSpringBody, springBody, world);  // For now, the rest angle doesn't need to be set (we need to know what the spring line is attached to first)
-			if (prevPrevSpringBody) s->setPrevBody(prevPrevSpringBody);
-			s->setRestAngle(10.0f * DEGTORAD);
-
-			springs.push_back(s);
+		if (prevSpringBody != SpringStore::NO_BODY) {
+			springs.add(prevPrevSpringBody, prevSpringBody, springBodyIndex, positions);
 			prevPrevSpringBody = prevSpringBody;
 		}
-		prevSpringBody = springBody;
+		prevSpringBody = springBodyIndex;
 	}
-	lastBody = prevSpringBody;
-	
-	SpringLine* line = new SpringLine(from, to, springs, restAngleFunc);
-	line->startBody = firstBody;
-line->endBody = lastBody;
-
-springLines.push_back(line);
 }
 
-void SpringWorld::createSpringLine(Edge edge, unsigned int numSegments, RASF restAngleFunc, bool dynamic) {
-	createSpringLine(edge.a, edge.b, numSegments, restAngleFunc, dynamic);
+void SpringWorld::createSpringLine(Edge edge, unsigned int numSegments, RASFSettings rasf, bool dynamic) {
+	createSpringLine(edge.a, edge.b, numSegments, rasf, dynamic);
 }
 
 // numSegments: number of segments per box side
 // sideAngle: angle of springs of box sides (corners are 90 degrees)
 void SpringWorld::createSpringBox(unsigned int numSegments, RASF_TYPE type, float32 sideAngle) {
 
-	auto func = getRASF(type, sideAngle);
+	RASFSettings rasf(type, sideAngle);
 
-	createSpringLine(b2Vec2(-5.0f, -5.0f), b2Vec2(5.0f, -5.0f), numSegments, func);
-	createSpringLine(b2Vec2(5.0f, -5.0f), b2Vec2(5.0f, 5.0f), numSegments, func);
-	createSpringLine(b2Vec2(5.0f, 5.0f), b2Vec2(-5.0f, 5.0f), numSegments, func);
-	createSpringLine(b2Vec2(-5.0f, 5.0f), b2Vec2(-5.0f, -5.0f), numSegments, func);
+	createSpringLine(b2Vec2(-5.0f, -5.0f), b2Vec2(5.0f, -5.0f), numSegments, rasf);
+	createSpringLine(b2Vec2(5.0f, -5.0f), b2Vec2(5.0f, 5.0f), numSegments, rasf);
+	createSpringLine(b2Vec2(5.0f, 5.0f), b2Vec2(-5.0f, 5.0f), numSegments, rasf);
+	createSpringLine(b2Vec2(-5.0f, 5.0f), b2Vec2(-5.0f, -5.0f), numSegments, rasf);
 
 	initSpringWorld();
 }
 
 
-void SpringWorld::createSystem(Border border, std::vector<Edge> edges, RASF_TYPE type, float32 angleSeverity) {
-	auto func = getRASF(type, angleSeverity);
+void SpringWorld::createSystem(Border border, const VoronoiGraph& graph, RASF_TYPE type, float32 angleSeverity) {
+	RASFSettings rasf(type, angleSeverity);
 
 	border.minX *= INVSCALE;
 	border.minY *= INVSCALE;
@@ -266,8 +771,10 @@ void SpringWorld::createSystem(Border border, std::vector<Edge> edges, RASF_TYPE
 	border.maxY *= INVSCALE;
 
 
-	for (Edge e : edges) {
+	unsigned int firstLine = (unsigned int)springLines.size();
 
+	for (const VoronoiGraph::GraphEdge& graphEdge : graph.edges) {
+		Edge e(graph.vertices[graphEdge.a], graph.vertices[graphEdge.b]);
 
 		float32 distance = b2Distance(e.a, e.b);
 
@@ -278,31 +785,35 @@ void SpringWorld::createSystem(Border border, std::vector<Edge> edges, RASF_TYPE
 
 		// If either edge end is within border, line is dynamic
 		if (border.isWithinBorder(e.a) || border.isWithinBorder(e.b)) {
-			createSpringLine(e, numSegments, func, true);
+			createSpringLine(e, numSegments, rasf, true);
 		}
 		// If both ends are outside border, it is a non-dynamic border line
 		else {
-			createSpringLine(e, numSegments, func, false);
+			createSpringLine(e, numSegments, rasf, false);
 		}
 	}
 
-	initSpringWorld();
-
+	// The graph already knows which lines meet, no need to search for them by distance
+	connectSpringLines(graph, firstLine);
+	subdivideSpringLines();
+	createBodies();
+	initRestAngles();
+	createSpringJoints();
 }
 
 void SpringWorld::createSquiggle(unsigned int numSegments, RASF_TYPE type, float32 angleSeverity)
 {
-	auto func = getRASF(type, angleSeverity);
+	RASFSettings rasf(type, angleSeverity);
 
-	createSpringLine(b2Vec2(-10.0f, -5.0f), b2Vec2(0.0f, -5.0f), numSegments, func);
-	createSpringLine(b2Vec2(0.0f, -5.0f), b2Vec2(0.0f, 5.0f), numSegments, func);
-	createSpringLine(b2Vec2(0.0f, 5.0f), b2Vec2(10.0f, 5.0f), numSegments, func);
+	createSpringLine(b2Vec2(-10.0f, -5.0f), b2Vec2(0.0f, -5.0f), numSegments, rasf);
+	createSpringLine(b2Vec2(0.0f, -5.0f), b2Vec2(0.0f, 5.0f), numSegments, rasf);
+	createSpringLine(b2Vec2(0.0f, 5.0f), b2Vec2(10.0f, 5.0f), numSegments, rasf);
 
 	initSpringWorld();
 }
 
 
-void SpringWorld::drawTree(float32 x1, float32 y1, float32 angle, int depth, RASF func)
+void SpringWorld::drawTree(float32 x1, float32 y1, float32 angle, int depth, RASFSettings rasf)
 {
 	if (depth) {
 		float32 x2 = (x1 + std::cos(angle) * depth * 1.05f);
@@ -313,18 +824,18 @@ void SpringWorld::drawTree(float32 x1, float32 y1, float32 angle, int depth, RAS
 
 		if (numSegments == 0) numSegments = 1;
 
-		createSpringLine(b2Vec2(x1, y1), b2Vec2(x2, y2), numSegments, func);
-		drawTree(x2, y2, angle - (35.0f * DEGTORAD), depth - 1, func);
-		drawTree(x2, y2, angle + (35.0f * DEGTORAD), depth - 1, func);
-		//drawTree(x2, y2, angle + (20.0f * DEGTORAD), depth - 1, func);
-		//drawTree(x2, y2, angle - (20.0f * DEGTORAD), depth - 1, func);
+		createSpringLine(b2Vec2(x1, y1), b2Vec2(x2, y2), numSegments, rasf);
+		drawTree(x2, y2, angle - (35.0f * DEGTORAD), depth - 1, rasf);
+		drawTree(x2, y2, angle + (35.0f * DEGTORAD), depth - 1, rasf);
+		//drawTree(x2, y2, angle + (20.0f * DEGTORAD), depth - 1, rasf);
+		//drawTree(x2, y2, angle - (20.0f * DEGTORAD), depth - 1, rasf);
 	}
 }
 
-void SpringWorld::drawRandomizedTree(float32 x1, float32 y1, float32 angle, int depth, RASF func)
+void SpringWorld::drawRandomizedTree(float32 x1, float32 y1, float32 angle, int depth, RASFSettings rasf, Random& rng)
 {
 	if (depth) {
-		float32 randDist = RandomFloat(0.1f, 1.4f);
+		float32 randDist = RandomFloat(rng, 0.1f, 1.4f);
 		//std::cout << randDist << std::endl;
 		float32 x2 = (x1 + std::cos(angle) * depth * randDist);
 		float32 y2 = (y1 + std::sin(angle) * depth * randDist);
@@ -334,44 +845,59 @@ void SpringWorld::drawRandomizedTree(float32 x1, float32 y1, float32 angle, int
 
 		if (numSegments == 0) numSegments = 1;
 
-		createSpringLine(b2Vec2(x1, y1), b2Vec2(x2, y2), numSegments, func);
+		createSpringLine(b2Vec2(x1, y1), b2Vec2(x2, y2), numSegments, rasf);
 		
-		float32 randomAngle = RandomFloat(10.0f, 30.0f);
+		float32 randomAngle = RandomFloat(rng, 10.0f, 30.0f);
 				
-		if (RandomFloat(0.0f, 1.0f) > 0.04f) {
-			drawRandomizedTree(x2, y2, angle - (randomAngle * DEGTORAD), depth - 1, func);
-			drawRandomizedTree(x2, y2, angle + (randomAngle * DEGTORAD), depth - 1, func);
+		if (RandomFloat(rng, 0.0f, 1.0f) > 0.04f) {
+			drawRandomizedTree(x2, y2, angle - (randomAngle * DEGTORAD), depth - 1, rasf, rng);
+			drawRandomizedTree(x2, y2, angle + (randomAngle * DEGTORAD), depth - 1, rasf, rng);
 		}
 	}
 }
 
 void SpringWorld::createFractalTree(unsigned int fractalDepth, RASF_TYPE type, float32 angleSeverity)
 {
-	auto func = getRASF(type, angleSeverity);
+	RASFSettings rasf(type, angleSeverity);
 
-	drawTree(0.0f, 7.0f, -90.0f * DEGTORAD, fractalDepth, func);
+	drawTree(0.0f, 7.0f, -90.0f * DEGTORAD, fractalDepth, rasf);
 	
 	initSpringWorld();
 }
 
 void SpringWorld::createRandomizedFractalTree(unsigned int fractalDepth, RASF_TYPE type, float32 rasfValue)
 {
-	auto func = getRASF(type, rasfValue);
+	RASFSettings rasf(type, rasfValue);
 
-	drawRandomizedTree(0.0f, 14.0f, -90.0f * DEGTORAD, fractalDepth, func);
+	drawRandomizedTree(0.0f, 14.0f, -90.0f * DEGTORAD, fractalDepth, rasf, rng);
 
 	initSpringWorld();
 }
 
 
 
-std::vector<Edge> SpringWorld::getSpringEdges()
+std::vector<Edge> SpringWorld::getSpringEdges() const
 {
 	std::vector<Edge> edges;
-	for (SpringLine* sl : springLines) {
-		for (Spring* s : sl->springs) {
-			edges.push_back(Edge(s->body->GetPosition(), s->nextBody->GetPosition()));
-		}
-	}
+	getSpringEdges(edges);
 	return edges;
 }
+
+void SpringWorld::getSpringEdges(std::vector<Edge>& edges) const
+{
+	edges.clear();
+	edges.reserve(springs.size());
+	forEachSpringEdge([&edges](unsigned int, const b2Vec2& a, const b2Vec2& b) {
+		edges.push_back(Edge(a, b));
+	});
+}
+
+unsigned int SpringWorld::getSpringCount() const
+{
+	return springs.size();
+}
+
+Edge SpringWorld::getSpringEdge(unsigned int i) const
+{
+	return Edge(getBodyPosition(springs.body[i]), getBodyPosition(springs.nextBody[i]));
+}
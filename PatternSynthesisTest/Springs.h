@@ -1,5 +1,6 @@
 #pragma once
 #include <Box2D\Box2D.h>
+#include <Box2D\Rope\b2SpringNetwork.h>
 
 #include <vector>
 #include <functional>
@@ -7,6 +8,7 @@
 
 #include "Voronoi.h"
 #include "RASF.h"
+#include "ThreadPool.h"
 
 
 float32 lerp(float32 a, float32 b, float32 t);
@@ -20,39 +22,49 @@ struct Border {
 	}
 };
 
-struct Spring {
+// All springs in the world, stored as parallel arrays so the force pass walks memory linearly
+// instead of chasing a heap allocated object (and three b2Body pointers) per spring
+// Bodies are referred to by index into SpringWorld's body/position/force arrays
+struct SpringStore {
+	static const int32 NO_BODY = -1;
+
 	// The previous body in the line is required to apply the correct torque for the angular component of the spring
-	// It is not required for the linear (distance) component
-	b2Body* prevBody = nullptr;
+	// It is not required for the linear (distance) component, and is NO_BODY for the first spring in a line
+	std::vector<int32> prevBody;
+	std::vector<int32> body;
+	std::vector<int32> nextBody;
 
-	b2Body* body = nullptr;
-	b2Body* nextBody = nullptr;
+	std::vector<float32> restAngle; // Target angle between prevBody and nextBody (from body) (where flat = 0). In radians.
+	std::vector<float32> baseLineAngle;
+	std::vector<float32> restLength; // Target length between body and nextBody
 
-	float32 restAngle = 0.0f; // Target angle between prevBody and bodyB (from bodyA) (where flat = 0). In radians.
-	float32 baseLineAngle = 0.0f;
-	float32 restLength = 0.0f; // Target length between 
+	std::vector<float32> linearK;
+	std::vector<float32> rotK;
 
-	float32 linearK = 20.0f;
-	float32 rotK = 20.0f;
+	unsigned int size() const { return (unsigned int)body.size(); }
 
-	Spring(b2Body* body, b2Body* nextBody, b2World* world);
-	
-	void setPrevBody(b2Body* prevBody);
-	void setRestAngle(float32 angle);
+	// Adds a spring between body and nextBody, rest length and base line angle are taken from the current positions
+	void add(int32 prevBody, int32 body, int32 nextBody, const std::vector<b2Vec2>& positions);
+
+	// Accumulates the linear and angular forces of springs [begin, end) into forces (indexed like positions)
+	// One spring at a time, angles in double precision. See SpringKernel.h for the faster batched version
+	void accumulateForces(const b2Vec2* positions, b2Vec2* forces, unsigned int begin, unsigned int end) const;
 
-	// Applies forces to bodies, pulling them together or pushing them apart based on distance
-	// (Does not deal with rotational spring forces, those are only applicable when considering the entire spring line)
-	void updateForces();
+	// Largest distance from rest length and from rest angle over springs [begin, end), combined with the values already in maxLength/maxAngle
+	void measureResiduals(const b2Vec2* positions, unsigned int begin, unsigned int end, float32& maxLength, float32& maxAngle) const;
 };
 
 struct SpringLine {
-	std::vector<Spring*> springs;
+	// This line's springs are [firstSpring, firstSpring + numSprings) in the SpringStore
+	unsigned int firstSpring = 0;
+	unsigned int numSprings = 0;
 
 	b2Vec2 startPoint; // point the spring line starts at (Part of spring line)
 	b2Vec2 endPoint; // point the spring line ends at (Part of spring line)
 
-	b2Body* startBody = nullptr;
-	b2Body* endBody = nullptr;
+	// Indices into SpringWorld's bodies, NO_BODY until the line's bodies are planned
+	int32 startBody = SpringStore::NO_BODY;
+	int32 endBody = SpringStore::NO_BODY;
 
 	// Vector for holding the angles of all the springlines the start point of the line 
 	// is connected to (clockwise angle relative to this line's angle) (in radians)
@@ -61,36 +73,174 @@ struct SpringLine {
 	// is connected to (clockwise angle relative to this line's angle) (in radians)
 	std::vector<float32> endAngles; 
 
-	std::function<float32(std::vector<float32>, std::vector<float32>, float32, unsigned int)> restAngleFunc;
+	RASFSettings rasf; // Sets this line's rest angles, once it knows what it is connected to
+	Random rng; // Only used by this line's RASF
 
 	float32 initialAngle = 0.0f;
 
-	SpringLine(b2Vec2 startPoint, b2Vec2 endPoint, std::vector<Spring*> springs, RASF restAngleFunc);
+	// Adaptive lines wait for their rest angles before creating bodies, see SpringWorld::setSubdivision
+	bool adaptive = false;
+	bool dynamic = true;
+	unsigned int plannedSegments = 0; // Springs the line would have without merging
+
+	SpringLine(b2Vec2 startPoint, b2Vec2 endPoint, unsigned int firstSpring, unsigned int numSprings, RASFSettings rasf, Random rng);
+};
+
+// Two spring lines jointed at the given ends
+struct LineJoin {
+	unsigned int s1, s2; // Indices of the lines, s1 < s2
+	bool s1End, s2End;
+
+	bool operator<(const LineJoin& other) const;
+};
+
+// Adaptive subdivision, see SpringWorld::setSubdivision
+struct SubdivisionSettings {
+	bool enabled = false;
+	float32 maxBend = 2.0f * DEGTORAD; // Most the rest angles of the bodies dropped from one merged spring can add up to (radians)
+	unsigned int maxMerge = 8; // Most planned springs merged into one
+};
+
+enum FORCE_KERNEL {
+	FORCE_KERNEL_BATCHED, // SIMD batches of springs, single precision with approximated atan2 (default)
+	FORCE_KERNEL_REFERENCE // One spring at a time, double precision angles. Slower, used to check the batched kernel
+};
+
+enum SPRING_SOLVER {
+	SPRING_SOLVER_FORCES, // Explicit forces, applied by the force kernel before every step (default)
+	SPRING_SOLVER_JOINTS, // One b2SpringJoint per spring, solved implicitly along with the line joints. Stays stable with stiffer springs and longer time steps
+	SPRING_SOLVER_NETWORK // No Box2D bodies at all, point masses in a b2SpringNetwork (XPBD) with joined line ends sharing one node. Much less memory per body
+};
+
+enum STEP_MODE {
+	STEP_MODE_ITERATIONS, // One world step per update with many solver iterations, joints are rigid (default)
+	STEP_MODE_SUBSTEP // Several short world steps per update with a few iterations each, joints are soft and spring forces are recomputed every sub-step
+};
+
+// How update steps the world, see SpringWorld::setStepSettings
+struct StepSettings {
+	STEP_MODE mode = STEP_MODE_ITERATIONS;
+	int32 velocityIterations = 80;
+	int32 positionIterations = 30;
+	// Velocity iterations stop early once one changes no body's velocity by more than this (m/s), 0 always runs them all
+	float32 velocityTolerance = 0.0f;
+
+	// STEP_MODE_SUBSTEP only
+	unsigned int substeps = 4;
+	int32 substepIterations = 4; // Velocity iterations per sub-step, there is one position iteration (soft joints skip it)
+	float32 jointHertz = 60.0f; // Stiffness of the soft joints, as a natural frequency
+	float32 jointDampingRatio = 1.0f;
+
+	// SPRING_SOLVER_NETWORK only, constraint iterations per step (or per sub-step in STEP_MODE_SUBSTEP)
+	int32 networkIterations = 10;
+};
+
+// Solver iterations the world steps actually ran, see SpringWorld::getSolverStats
+// Each world step counts the most iterations any one island ran in it
+struct SolverStats {
+	unsigned int worldSteps = 0;
+	unsigned long long velocityIterations = 0;
+	unsigned int maxVelocityIterations = 0;
+	unsigned long long positionIterations = 0;
+	unsigned int maxPositionIterations = 0;
+
+	float32 averageVelocityIterations() const;
+	float32 averagePositionIterations() const;
+};
+
+// When a pattern counts as settled, see SpringWorld::setConvergenceCriteria
+// A threshold of 0 is ignored, the pattern has settled once all the others hold
+struct ConvergenceCriteria {
+	float32 kineticEnergy = 0.0f; // Total kinetic energy of every body (J)
+	float32 maxSpeed = 0.0f; // Fastest body (m/s)
+	float32 lengthResidual = 0.0f; // Furthest any spring is from its rest length (m)
+	float32 angleResidual = 0.0f; // Furthest any spring is from its rest angle (radians). Crowded patterns can settle well away from their rest angles
+	unsigned int checkInterval = 10; // Steps between checks, measuring residuals costs about as much as a force pass
+
+	bool isEnabled() const;
+};
+
+struct ConvergenceStats {
+	float32 kineticEnergy = 0.0f;
+	float32 maxSpeed = 0.0f;
+	float32 lengthResidual = 0.0f;
+	float32 angleResidual = 0.0f;
+
+	bool meets(const ConvergenceCriteria& criteria) const;
 };
 
 // To store all spring lines in vector for updating, creating new spring lines etc.
 struct SpringWorld {
 
 public:
-	SpringWorld(b2World* world) : world(world) {}
+	// seed: every random choice made while creating patterns comes from this, so the same seed gives the same pattern
+	SpringWorld(b2World* world, uint64_t seed = 0) : world(world), rng(seed) {}
+	~SpringWorld();
 	
 	b2World* getWorld();
 
+	// The world's generator, for anything random that goes into a pattern (e.g. Voronoi points)
+	Random& getRandom();
+
+	void setForceKernel(FORCE_KERNEL kernel);
+
+	// Spreads the force pass and the world's island solving across the pool's threads (nullptr to run them on the calling thread only)
+	// The pool is not owned by the SpringWorld and must outlive it
+	void setThreadPool(ThreadPool* pool);
+	ThreadPool* getThreadPool() const;
+
 	// Apply forces on all springs, and takes physics timestep
+	// Does nothing once the pattern has converged (see setConvergenceCriteria)
 	void update(float32 timeStep);
 
-	void createSpringLine(b2Vec2 from, b2Vec2 to, unsigned int numSegments, RASF restAngleFunc, bool dynamic = true);
+	// Checked every criteria.checkInterval steps of update, which stops stepping once they are met
+	// With no thresholds set (the default) the pattern never counts as converged
+	void setConvergenceCriteria(const ConvergenceCriteria& criteria);
+	bool hasConverged() const;
+	unsigned int getStepCount() const;
+
+	// Current kinetic energy, speed and spring residuals, measured right now
+	ConvergenceStats measureConvergence();
+
+	// Lets Box2D put settled bodies to sleep. A sleeping body is only woken by a spring force stronger than wakeForce (N),
+	// smaller forces on it are dropped. Off by default, every body is woken every step
+	void setSleeping(bool enabled, float32 wakeForce = 1.0f);
+
+	// Lines created after this plan numSegments springs, but only keep bodies where their rest angles bend the line,
+	// runs of planned springs that stay (nearly) straight are merged into one longer spring. Fewer bodies for the same shape
+	// Rest angles depend on what a line is connected to, so its bodies are created when it is connected (see initSpringWorld)
+	// Off by default, every planned spring gets its own bodies
+	void setSubdivision(const SubdivisionSettings& settings);
 
-	void createSpringLine(Edge edge, unsigned int numSegments, RASF restAngleFunc, bool dynamic = true);
+	// Default is STEP_MODE_ITERATIONS with 80 velocity and 30 position iterations
+	// Joints are made soft when they are created, so set STEP_MODE_SUBSTEP before creating a pattern
+	void setStepSettings(const StepSettings& settings);
+	const StepSettings& getStepSettings() const;
+
+	// Iterations used by every world step since the pattern was created (sub-steps count as world steps)
+	const SolverStats& getSolverStats() const;
+
+	// How springs pull their bodies, stiffness scales every spring's linearK and rotK
+	// Spring joints and networks are created with the pattern, so set the solver before creating one
+	// SPRING_SOLVER_NETWORK leaves the b2World empty, and ignores the thread pool and sleeping
+	void setSpringSolver(SPRING_SOLVER solver, float32 stiffness = 1.0f);
+
+	// Bodies being simulated. With SPRING_SOLVER_NETWORK joined line ends share one, so there are fewer
+	unsigned int getBodyCount() const;
+
+	// Lines are only planned here, their bodies and joints are created all at once by initSpringWorld (or createSystem)
+	void createSpringLine(b2Vec2 from, b2Vec2 to, unsigned int numSegments, RASFSettings rasf, bool dynamic = true);
+
+	void createSpringLine(Edge edge, unsigned int numSegments, RASFSettings rasf, bool dynamic = true);
 
 	// numSegments: number of segments per box side
 	// sideAngle: angle of springs of box sides (corners are 90 degrees)
 	void createSpringBox(unsigned int numSegments,  RASF_TYPE type, float32 sideAngle);
 
 	// Border: Edges outside of border will be static (only if both points in edge are outside border)
-	// Edges: Edges of system
+	// Graph: Edges of system, lines are joined where edges share a vertex
 	// Angle Severity: rest angle function multiplier
-	void createSystem(Border border, std::vector<Edge> edges, RASF_TYPE type, float32 angleSeverity = 1.0f);
+	void createSystem(Border border, const VoronoiGraph& graph, RASF_TYPE type, float32 angleSeverity = 1.0f);
 	
 	// numSegments: number of segments per squiggle side
 	void createSquiggle(unsigned int numSegments, RASF_TYPE type, float32 angleSeverity = 1.0f);
@@ -99,25 +249,105 @@ public:
 	
 	void createRandomizedFractalTree(unsigned int fractalDepth, RASF_TYPE type, float32 rasfValue = 1.0f);
 
-	std::vector<Edge> getSpringEdges();
+	std::vector<Edge> getSpringEdges() const;
+	// Fills edges with one edge per spring, reusing its memory so repeated calls don't allocate
+	void getSpringEdges(std::vector<Edge>& edges) const;
+
+	unsigned int getSpringCount() const;
+	// Current body positions at both ends of spring i (in [0, getSpringCount()))
+	Edge getSpringEdge(unsigned int i) const;
+
+	// Calls func(i, a, b) for every spring i, with a and b the current positions of its two bodies
+	// Nothing is copied or allocated, for renderers and exporters that walk the springs every frame
+	template <typename Func>
+	void forEachSpringEdge(Func func) const {
+		for (unsigned int i = 0; i < springs.size(); i++) {
+			func(i, getBodyPosition(springs.body[i]), getBodyPosition(springs.nextBody[i]));
+		}
+	}
 	
 	void initSpringWorld();
 private:
 
-	std::vector<SpringLine*> springLines;
-	std::vector<Spring*> connectiveSprings; // Springs connecting different spring lines
+	std::vector<SpringLine> springLines;
+	SpringStore springs;
+
+	// Every spring line body, springs refer to these by index
+	std::vector<b2Body*> bodies;
+	// With SPRING_SOLVER_NETWORK bodies stay nullptr, body i is node bodyNodes[i] of network instead
+	b2SpringNetwork network;
+	std::vector<int32> bodyNodes;
+	// Scratch buffers for update, gathered from/scattered to bodies once per step
+	std::vector<b2Vec2> positions;
+	std::vector<b2Vec2> forces;
 
 	b2World* world;
+	Random rng;
+
+	FORCE_KERNEL forceKernel = FORCE_KERNEL_BATCHED;
+	ThreadPool* threadPool = nullptr;
+	// Registered with the world while a thread pool is set
+	ThreadPoolTaskExecutor taskExecutor;
+
+	ConvergenceCriteria convergenceCriteria;
+	bool converged = false;
+	unsigned int stepCount = 0;
+
+	bool sleeping = false;
+	float32 wakeForceSquared = 0.0f;
+
+	SubdivisionSettings subdivision;
+	StepSettings stepSettings;
+	SolverStats solverStats;
+	SPRING_SOLVER springSolver = SPRING_SOLVER_FORCES;
+	float32 springStiffness = 1.0f;
+	// Bodies and joints waiting to be created in one go, see createBodies. Bodies get their index in bodies when they are queued
+	std::vector<b2BodyDef> bodyDefs;
+	std::vector<LineJoin> pendingJoins;
+	// Scratch for creating lines
+	std::vector<unsigned int> keptBodies;
+	std::vector<float32> plannedAngles;
+
+	b2Vec2 getBodyPosition(int32 i) const {
+		return springSolver == SPRING_SOLVER_NETWORK ? network.GetPositions()[bodyNodes[i]] : bodies[i]->GetPosition();
+	}
+
+	// Applies the accumulated force to body i, waking it unless sleeping is on and the force is small
+	void applyForce(unsigned int i);
+
+	// Accumulates forces of springs [begin, end) into forces using the selected kernel
+	void accumulateForces(unsigned int begin, unsigned int end);
+	// Multithreaded gather/force/scatter, see update
+	void updateForcesParallel();
+	// Gathers positions, accumulates every spring's force and applies it to the bodies
+	void applySpringForces();
+	// Steps the world and adds the iterations it ran to solverStats
+	void stepWorld(float32 timeStep, int32 velocityIterations, int32 positionIterations);
 
 	// Goes through spring lines and attaches them together
 	void connectSpringLines();
+	// Attaches the lines created for graph's edges (starting at springLines[firstLine]) where they share a vertex
+	void connectSpringLines(const VoronoiGraph& graph, unsigned int firstLine);
+	// Queues a joint between s1 and s2 at the given ends and records each one's angle relative to the other
+	void joinSpringLines(unsigned int s1, bool s1End, unsigned int s2, bool s2End);
+	void createJoint(const LineJoin& join);
+	// Queues the bodies of planned spring line numSegments that are listed in kept (0 to numSegments), and adds springs between them
+	void createLineBodies(b2Vec2 from, b2Vec2 to, unsigned int numSegments, const std::vector<unsigned int>& kept, bool dynamic);
+	// Plans the bodies and rest angles of adaptive lines now that they are connected
+	void subdivideSpringLines();
+	// Creates every queued body with one b2World::CreateBodies call, so the broad-phase is built once, then the queued joints
+	void createBodies();
+	// Same for SPRING_SOLVER_NETWORK, adds network nodes for the queued bodies, one per group of joined line ends
+	void createNetworkNodes();
 	// Goes through spring lines and sets inner rest angles based on that spring line's RASF
 	void initRestAngles();
+	// Creates a b2SpringJoint (or network constraints) for every spring, once rest angles are set. Not for SPRING_SOLVER_FORCES
+	void createSpringJoints();
 	
 	// Connects spring lines together then initializes rest angles
 
-	void drawTree(float32 x1, float32 y1, float32 angle, int depth, RASF func);
-	void drawRandomizedTree(float32 x1, float32 y1, float32 angle, int depth, RASF func);
+	void drawTree(float32 x1, float32 y1, float32 angle, int depth, RASFSettings rasf);
+	void drawRandomizedTree(float32 x1, float32 y1, float32 angle, int depth, RASFSettings rasf, Random& rng);
 };
 
 
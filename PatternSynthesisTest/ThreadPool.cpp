@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads) :
+	nextIndex(0)
+{
+	if (numThreads == 0) numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0) numThreads = 1; // hardware_concurrency is allowed to not know
+
+	// The calling thread is thread 0, so one less worker is needed
+	for (unsigned int i = 1; i < numThreads; i++) {
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	workReady.notify_all();
+
+	for (std::thread& worker : workers) worker.join();
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& task)
+{
+	if (workers.empty() || count <= 1) {
+		for (unsigned int i = 0; i < count; i++) task(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = &task;
+		taskCount = count;
+		nextIndex = 0;
+		busyWorkers = (unsigned int)workers.size();
+		generation++;
+	}
+	workReady.notify_all();
+
+	runTasks(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [this] { return busyWorkers == 0; });
+	this->task = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int threadIndex)
+{
+	unsigned int seenGeneration = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [this, seenGeneration] { return quit || generation != seenGeneration; });
+			if (quit) return;
+			seenGeneration = generation;
+		}
+
+		runTasks(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busyWorkers == 0) workDone.notify_one();
+		}
+	}
+}
+
+void ThreadPool::runTasks(unsigned int threadIndex)
+{
+	// Indices are handed out one at a time so uneven tasks still balance
+	for (unsigned int i = nextIndex++; i < taskCount; i = nextIndex++) {
+		(*task)(i, threadIndex);
+	}
+}
+
+void ThreadPoolTaskExecutor::setThreadPool(ThreadPool* pool)
+{
+	this->pool = pool;
+}
+
+int32 ThreadPoolTaskExecutor::GetThreadCount() const
+{
+	return pool ? (int32)pool->getThreadCount() : 1;
+}
+
+void ThreadPoolTaskExecutor::ParallelFor(b2Task* task, int32 count)
+{
+	if (pool == nullptr) {
+		for (int32 i = 0; i < count; i++) task->Execute(i, 0);
+		return;
+	}
+	pool->parallelFor((unsigned int)count, [task](unsigned int index, unsigned int threadIndex) {
+		task->Execute((int32)index, (int32)threadIndex);
+	});
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include <Box2D\Box2D.h>
+
+// Fixed set of worker threads that split loops between themselves and the calling thread
+struct ThreadPool {
+
+public:
+	// numThreads: threads working on each parallelFor, including the calling thread (0 = one per core)
+	ThreadPool(unsigned int numThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int getThreadCount() const;
+
+	// Calls task(index, threadIndex) for every index in [0, count) and returns once they have all finished
+	// threadIndex is in [0, getThreadCount()), 0 being the calling thread, so it can be used to pick per-thread scratch data
+	// Only one parallelFor may run at a time, and tasks must not call parallelFor themselves
+	void parallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& task);
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+
+	// Current parallelFor, workers pick up a new one whenever generation changes
+	const std::function<void(unsigned int, unsigned int)>* task = nullptr;
+	unsigned int taskCount = 0;
+	std::atomic<unsigned int> nextIndex;
+	unsigned int busyWorkers = 0;
+	unsigned int generation = 0;
+	bool quit = false;
+
+	void workerLoop(unsigned int threadIndex);
+	void runTasks(unsigned int threadIndex);
+};
+
+// Lets a b2World solve its islands on a ThreadPool, see b2World::SetTaskExecutor
+struct ThreadPoolTaskExecutor : public b2TaskExecutor {
+
+public:
+	ThreadPoolTaskExecutor(ThreadPool* pool = nullptr) : pool(pool) {}
+
+	void setThreadPool(ThreadPool* pool);
+
+	int32 GetThreadCount() const override;
+	void ParallelFor(b2Task* task, int32 count) override;
+
+private:
+	ThreadPool* pool;
+};
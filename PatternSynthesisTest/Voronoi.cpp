@@ -3,20 +3,252 @@
 #include "Voronoi.h"
 #include "jc_voronoi.h"
 #include "util.h"
-#include <time.h>
-#include <iostream>
+#include "ThreadPool.h"
+#include <algorithm>
 
+bool VoronoiGraph::Corner::operator<(const Corner& other) const
+{
+	if (cells[0] != other.cells[0]) return cells[0] < other.cells[0];
+	if (cells[1] != other.cells[1]) return cells[1] < other.cells[1];
+	return cells[2] < other.cells[2];
+}
+
+bool VoronoiGraph::Corner::operator==(const Corner& other) const
+{
+	return cells[0] == other.cells[0] && cells[1] == other.cells[1] && cells[2] == other.cells[2];
+}
+
+void VoronoiGraph::build(const std::vector<Edge>& edges, const std::vector<Corner>& endCorners, const std::vector<std::pair<Corner, Corner>>& sameCorners)
+{
+	// Number every distinct corner
+	corners.assign(endCorners.begin(), endCorners.end());
+	for (const std::pair<Corner, Corner>& same : sameCorners) {
+		corners.push_back(same.first);
+		corners.push_back(same.second);
+	}
+	std::sort(corners.begin(), corners.end());
+	corners.erase(std::unique(corners.begin(), corners.end()), corners.end());
+	auto cornerIndex = [this](const Corner& corner) {
+		return (unsigned int)(std::lower_bound(corners.begin(), corners.end(), corner) - corners.begin());
+	};
+
+	// Union-find merges corners that are the same vertex
+	parent.resize(corners.size());
+	for (unsigned int i = 0; i < parent.size(); i++) parent[i] = i;
+	auto find = [this](unsigned int i) {
+		while (parent[i] != i) i = parent[i] = parent[parent[i]];
+		return i;
+	};
+	for (const std::pair<Corner, Corner>& same : sameCorners) {
+		unsigned int a = find(cornerIndex(same.first));
+		unsigned int b = find(cornerIndex(same.second));
+		parent[b2Max(a, b)] = b2Min(a, b);
+	}
+
+	// Vertices are numbered in the order edges first reach them, at the position of that end
+	const unsigned int NO_VERTEX = 0xffffffff;
+	cornerVertex.assign(corners.size(), NO_VERTEX);
+	vertices.clear();
+	this->edges.resize(edges.size());
+	for (unsigned int i = 0; i < edges.size() * 2; i++) {
+		unsigned int root = find(cornerIndex(endCorners[i]));
+		if (cornerVertex[root] == NO_VERTEX) {
+			cornerVertex[root] = (unsigned int)vertices.size();
+			vertices.push_back((i & 1) ? edges[i / 2].b : edges[i / 2].a);
+		}
+		if (i & 1) this->edges[i / 2].b = cornerVertex[root];
+		else this->edges[i / 2].a = cornerVertex[root];
+	}
+
+	// Group the edge ends by vertex
+	incidenceStart.assign(vertices.size() + 1, 0);
+	for (const GraphEdge& e : this->edges) {
+		incidenceStart[e.a + 1]++;
+		incidenceStart[e.b + 1]++;
+	}
+	for (unsigned int v = 0; v < vertices.size(); v++) incidenceStart[v + 1] += incidenceStart[v];
+
+	incidences.resize(edges.size() * 2);
+	nextIncidence.assign(incidenceStart.begin(), incidenceStart.end() - 1);
+	for (unsigned int i = 0; i < edges.size(); i++) {
+		b2Vec2 d = vertices[this->edges[i].b] - vertices[this->edges[i].a];
+		incidences[nextIncidence[this->edges[i].a]++] = { i, std::atan2(d.y, d.x) };
+		incidences[nextIncidence[this->edges[i].b]++] = { i, std::atan2(-d.y, -d.x) };
+	}
+	for (unsigned int v = 0; v < vertices.size(); v++) {
+		std::sort(incidences.begin() + incidenceStart[v], incidences.begin() + incidenceStart[v + 1], [](const Incidence& l, const Incidence& r) {
+			if (l.angle != r.angle) return l.angle < r.angle;
+			return l.edge < r.edge;
+		});
+	}
+}
+
+VoronoiArena::VoronoiArena(size_t chunkSize) :
+	chunkSize(chunkSize)
+{
+}
+
+void* VoronoiArena::allocate(size_t size)
+{
+	size = (size + 15) & ~(size_t)15;
+
+	// Move on to the next chunk that fits, adding one if none do
+	while (currentChunk < chunks.size() && chunks[currentChunk].used + size > chunks[currentChunk].size) currentChunk++;
+	if (currentChunk == chunks.size()) addChunk(b2Max(size, chunkSize));
+
+	Chunk& chunk = chunks[currentChunk];
+	void* p = chunk.data.get() + chunk.used;
+	chunk.used += size;
+	return p;
+}
+
+void VoronoiArena::reset()
+{
+	// Needed more than one chunk, swap them for a single chunk big enough for all of it so next time is one contiguous block
+	if (chunks.size() > 1) {
+		size_t capacity = getCapacity();
+		chunks.clear();
+		addChunk(capacity);
+	}
+	for (Chunk& chunk : chunks) chunk.used = 0;
+	currentChunk = 0;
+}
+
+size_t VoronoiArena::getCapacity() const
+{
+	size_t capacity = 0;
+	for (const Chunk& chunk : chunks) capacity += chunk.size;
+	return capacity;
+}
+
+void VoronoiArena::addChunk(size_t size)
+{
+	// Chunks are allocated with new[], which only promises alignment for the largest fundamental type, so allocate extra to align by hand
+	Chunk chunk;
+	chunk.data.reset(new char[size + 15]);
+	chunk.size = size;
+	chunk.used = (16 - ((size_t)chunk.data.get() & 15)) & 15;
+	chunk.size += chunk.used;
+	chunks.push_back(std::move(chunk));
+}
+
+// Points per squared minimum distance that Poisson-disk sampling packs in
+static const float32 POISSON_DENSITY = 0.65f;
+
+// jc_voronoi allocation callbacks, everything is freed by VoronoiArena::reset instead
+static void* arenaAlloc(void* arena, size_t size)
+{
+	return ((VoronoiArena*)arena)->allocate(size);
+}
 
-Voronoi::Voronoi(float32 width, float32 height, std::vector<b2Vec2> points) {
-	createDiagram(width, height, points);
+static void arenaFree(void*, void*)
+{
+}
+
+static jcv_rect centeredRect(float32 width, float32 height)
+{
+	jcv_rect rect;
+	rect.min = { -width / 2, -height / 2 };
+	rect.max = { width / 2, height / 2 };
+	return rect;
+}
 
+// Resets the arena and builds the diagram for points in it, the diagram is valid until the next reset
+// Points outside rect are left out
+static void generateDiagram(const std::vector<b2Vec2>& points, const jcv_rect& rect, VoronoiArena& arena, jcv_diagram& diagram)
+{
+	arena.reset();
+
+	jcv_point* jcvPoints = (jcv_point*)arena.allocate(points.size() * sizeof(jcv_point));
+	for (unsigned int i = 0; i < points.size(); i++) {
+		jcvPoints[i] = { points[i].x, points[i].y };
+	}
+
+	memset(&diagram, 0, sizeof(jcv_diagram));
+	jcv_diagram_generate_useralloc(points.size(), jcvPoints, &rect, &arena, arenaAlloc, arenaFree, &diagram);
+}
 
+// Area weighted centroid of a site's cell, as a fan of triangles from the site through each of its edges
+// Cells with no area (e.g. duplicate points jc_voronoi dropped) keep their point
+static b2Vec2 cellCentroid(const jcv_site& site)
+{
+	b2Vec2 p((float32)site.p.x, (float32)site.p.y);
+	b2Vec2 sum(0.0f, 0.0f);
+	float32 area = 0.0f;
+
+	for (const jcv_graphedge* e = site.edges; e != nullptr; e = e->next) {
+		b2Vec2 a = b2Vec2((float32)e->pos[0].x, (float32)e->pos[0].y) - p;
+		b2Vec2 b = b2Vec2((float32)e->pos[1].x, (float32)e->pos[1].y) - p;
+		float32 triangleArea = b2Cross(a, b);
+		sum += triangleArea * (a + b);
+		area += triangleArea;
+	}
+
+	if (b2Abs(area) < b2_epsilon) return p;
+	// Each triangle's centroid is (p + a + b) / 3 relative to the site
+	return p + (1.0f / (3.0f * area)) * sum;
+}
+
+// Cells past the border are numbered down from the largest uint32, one per side
+static uint32 borderSide(const jcv_diagram& diagram, const jcv_graphedge& e)
+{
+	if (e.pos[0].y == diagram.min.y && e.pos[1].y == diagram.min.y) return 0xffffffff;
+	if (e.pos[0].x == diagram.max.x && e.pos[1].x == diagram.max.x) return 0xfffffffe;
+	if (e.pos[0].y == diagram.max.y && e.pos[1].y == diagram.max.y) return 0xfffffffd;
+	return 0xfffffffc;
+}
+
+static VoronoiGraph::Corner makeCorner(uint32 a, uint32 b, uint32 c)
+{
+	if (a > b) std::swap(a, b);
+	if (b > c) std::swap(b, c);
+	if (a > b) std::swap(a, b);
+	return { { a, b, c } };
 }
 
-Voronoi::Voronoi(float32 width, float32 height, unsigned int numPoints, VoronoiDistributionType distribType)
+// Calls func(edge, corner at edge->pos[0], corner at edge->pos[1]) for each of site's edges
+// indices maps the diagram's point indices to the ones the corners should use (nullptr to use them as they are)
+template <typename Func>
+static void forEachCellEdge(const jcv_diagram& diagram, const jcv_site& site, const unsigned int* indices, Func func)
 {
-	//srand(time(NULL));
-	std::vector<b2Vec2> randomPoints;
+	auto cell = [&](const jcv_graphedge* e) {
+		if (e->neighbor == nullptr) return borderSide(diagram, *e);
+		return indices ? (uint32)indices[e->neighbor->index] : (uint32)e->neighbor->index;
+	};
+	uint32 self = indices ? (uint32)indices[site.index] : (uint32)site.index;
+
+	// Edges go counter-clockwise around the cell, the corner between two of them is shared with the cell beyond each
+	const jcv_graphedge* last = site.edges;
+	while (last && last->next) last = last->next;
+	for (const jcv_graphedge* e = site.edges, *prev = last; e != nullptr; prev = e, e = e->next) {
+		const jcv_graphedge* next = e->next ? e->next : site.edges;
+		VoronoiGraph::Corner start = makeCorner(self, cell(prev), cell(e));
+		VoronoiGraph::Corner end = makeCorner(self, cell(e), cell(next));
+		// Graph edges copy their positions from the edge, but may run the other way
+		if (jcv_point_eq(&e->pos[0], &e->edge->pos[0])) func(e, start, end);
+		else func(e, end, start);
+	}
+}
+
+Voronoi::Voronoi(float32 width, float32 height, const std::vector<b2Vec2>& points) {
+	VoronoiArena arena;
+	generate(width, height, points, arena);
+}
+
+Voronoi::Voronoi(float32 width, float32 height, unsigned int numPoints, Random& rng, VoronoiDistributionType distribType)
+{
+	VoronoiArena arena;
+	generate(width, height, numPoints, rng, distribType, arena);
+}
+
+void Voronoi::generate(float32 width, float32 height, const std::vector<b2Vec2>& points, VoronoiArena& arena)
+{
+	createDiagram(width, height, points, arena);
+}
+
+void Voronoi::generate(float32 width, float32 height, unsigned int numPoints, Random& rng, VoronoiDistributionType distribType, VoronoiArena& arena)
+{
+	randomPoints.clear();
 	float32 minX = -width / 2.0f;
 	float32 minY = -height / 2.0f;
 	float32 maxX = width / 2.0f;
@@ -30,14 +262,20 @@ Voronoi::Voronoi(float32 width, float32 height, unsigned int numPoints, VoronoiD
 				float32 sectionSizeX = (maxX - minX) / numSectionsX;
 				float32 sectionSizeY = (maxY - minY) / numSectionsY;
 
-				std::vector<b2Vec2> newPoints;
-				newPoints = genRandomPoints(minX + (sectionSizeX * x), minX + (sectionSizeX * (x + 1)), minY + (sectionSizeY * y), minY + sectionSizeY * (y + 1), (numPoints / (numSectionsX * numSectionsX)) <= 0 ? 1 : (numPoints / (numSectionsX * numSectionsX)));
-				randomPoints.insert(std::end(randomPoints), std::begin(newPoints), std::end(newPoints));
+				genRandomPoints(minX + (sectionSizeX * x), minX + (sectionSizeX * (x + 1)), minY + (sectionSizeY * y), minY + sectionSizeY * (y + 1), (numPoints / (numSectionsX * numSectionsX)) <= 0 ? 1 : (numPoints / (numSectionsX * numSectionsX)), rng, randomPoints);
 			}
 		}
 	}
 	else if (distribType == RANDOM) {
-		randomPoints = genRandomPoints(minX, maxX, minY, maxY, numPoints);
+		genRandomPoints(minX, maxX, minY, maxY, numPoints, rng, randomPoints);
+	}
+	else if (distribType == CENTROIDAL) {
+		genRandomPoints(minX, maxX, minY, maxY, numPoints, rng, randomPoints);
+		relax(width, height, randomPoints, arena);
+	}
+	else if (distribType == POISSON_DISK) {
+		float32 distance = minDistance > 0.0f ? minDistance : std::sqrt(POISSON_DENSITY * width * height / b2Max(numPoints, 1u));
+		genPoissonDiskPoints(minX, maxX, minY, maxY, distance, rng, randomPoints);
 	}
 	else if (distribType == UNIFORM) {
 		unsigned int numPerDimension = std::sqrt(numPoints);
@@ -51,39 +289,355 @@ Voronoi::Voronoi(float32 width, float32 height, unsigned int numPoints, VoronoiD
 		}
 	}
 
-	createDiagram(width, height, randomPoints);
+	createDiagram(width, height, randomPoints, arena);
 }
 
-void Voronoi::createDiagram(float32 width, float32 height, std::vector<b2Vec2> points)
+void Voronoi::setThreadPool(ThreadPool* pool)
 {
-	std::cout << "Number of points: " << points.size() << std::endl;
-	jcv_diagram diagram;
-	jcv_point* jcvPoints = new jcv_point[points.size()];
+	this->pool = pool;
+}
 
-	for (int i = 0; i < points.size(); i++) {
-		jcvPoints[i] = { points[i].x, points[i].y };
-	}
+void Voronoi::setRelaxation(unsigned int iterations)
+{
+	relaxIterations = iterations;
+}
 
-	jcv_rect jcvRect;
-	jcvRect.min = { -width / 2, -height / 2 };
-	jcvRect.max = { width / 2, height / 2 };
+void Voronoi::setMinDistance(float32 distance)
+{
+	minDistance = distance;
+}
 
-	jcv_diagram_generate(points.size(), jcvPoints, &jcvRect, &diagram);
+void Voronoi::setTiling(unsigned int tilesPerSide)
+{
+	this->tilesPerSide = b2Max(tilesPerSide, 1u);
+}
 
+void Voronoi::relax(float32 width, float32 height, std::vector<b2Vec2>& points, VoronoiArena& arena)
+{
+	// Sites per parallelFor index, enough that handing them out is cheap next to the centroid maths
+	const unsigned int sitesPerTask = 256;
 
+	for (unsigned int iteration = 0; iteration < relaxIterations; iteration++) {
+		// jc_voronoi can't move sites in an existing diagram, so each iteration builds a new one in the same arena memory
+		jcv_diagram diagram;
+		generateDiagram(points, centeredRect(width, height), arena, diagram);
+
+		const jcv_site* sites = jcv_diagram_get_sites(&diagram);
+		unsigned int numSites = (unsigned int)diagram.numsites;
+
+		// The points were copied into the arena, so each site can write its own point without anything else reading it
+		auto moveToCentroids = [&](unsigned int task, unsigned int) {
+			unsigned int end = b2Min((task + 1) * sitesPerTask, numSites);
+			for (unsigned int i = task * sitesPerTask; i < end; i++) {
+				points[sites[i].index] = cellCentroid(sites[i]);
+			}
+		};
+		unsigned int numTasks = (numSites + sitesPerTask - 1) / sitesPerTask;
+		if (pool) pool->parallelFor(numTasks, moveToCentroids);
+		else for (unsigned int task = 0; task < numTasks; task++) moveToCentroids(task, 0);
+
+		jcv_diagram_free(&diagram);
+	}
+}
+
+void Voronoi::createDiagram(float32 width, float32 height, const std::vector<b2Vec2>& points, VoronoiArena& arena)
+{
+	if (tilesPerSide > 1) {
+		createTiledDiagram(width, height, points);
+		graph.build(edges, endCorners, sameCorners);
+		return;
+	}
+
+	jcv_diagram diagram;
+	generateDiagram(points, centeredRect(width, height), arena, diagram);
+
+	edges.clear();
+	edgeOrder.clear();
 	const jcv_edge* edgeP = jcv_diagram_get_edges(&diagram);
 	while (edgeP) {
+		edgeOrder.push_back(std::make_pair((const void*)edgeP, (unsigned int)edges.size()));
 		edges.push_back(Edge(b2Vec2((float32)edgeP->pos[0].x, (float32)edgeP->pos[0].y),
 			b2Vec2((float32)edgeP->pos[1].x, (float32)edgeP->pos[1].y)));
 		edgeP = jcv_diagram_get_next_edge(edgeP);
 	}
+
+	// Every edge is seen from the cells on both sides of it, which should agree on its corners
+	// Where they don't (more than three cells meeting at a corner) both corners are the same vertex
+	const VoronoiGraph::Corner UNSET = { { 0, 0, 0 } };
+	endCorners.assign(edges.size() * 2, UNSET);
+	sameCorners.clear();
+	auto setCorner = [this, &UNSET](unsigned int end, const VoronoiGraph::Corner& corner) {
+		if (endCorners[end] == UNSET) endCorners[end] = corner;
+		else if (!(endCorners[end] == corner)) sameCorners.push_back(std::make_pair(endCorners[end], corner));
+	};
+
+	std::sort(edgeOrder.begin(), edgeOrder.end());
+	const jcv_site* sites = jcv_diagram_get_sites(&diagram);
+	for (int i = 0; i < diagram.numsites; i++) {
+		forEachCellEdge(diagram, sites[i], nullptr, [&](const jcv_graphedge* e, const VoronoiGraph::Corner& start, const VoronoiGraph::Corner& end) {
+			auto it = std::lower_bound(edgeOrder.begin(), edgeOrder.end(), std::make_pair((const void*)e->edge, 0u));
+			if (it == edgeOrder.end() || it->first != e->edge) {
+				// Zero length edge that was left out, its ends are one vertex
+				sameCorners.push_back(std::make_pair(start, end));
+				return;
+			}
+			setCorner(it->second * 2, start);
+			setCorner(it->second * 2 + 1, end);
+		});
+	}
+
+	// Edges no cell has (should not happen) are left unconnected rather than all joined at one bogus corner
+	for (unsigned int i = 0; i < endCorners.size(); i++) {
+		if (endCorners[i] == UNSET) endCorners[i] = { { i, 0xfffffffb, 0xfffffffb } };
+	}
+
+	jcv_diagram_free(&diagram);
+
+	graph.build(edges, endCorners, sameCorners);
+}
+
+bool Voronoi::CornerView::operator<(const CornerView& other) const
+{
+	if (cells[0] != other.cells[0]) return cells[0] < other.cells[0];
+	if (cells[1] != other.cells[1]) return cells[1] < other.cells[1];
+	if (end != other.end) return end < other.end;
+	return corner < other.corner;
+}
+
+void Voronoi::createTiledDiagram(float32 width, float32 height, const std::vector<b2Vec2>& points)
+{
+	unsigned int numTiles = tilesPerSide * tilesPerSide;
+	float32 tileWidth = width / tilesPerSide;
+	float32 tileHeight = height / tilesPerSide;
+
+	auto tileOf = [&](const b2Vec2& p) {
+		int x = b2Clamp((int)((p.x + width / 2) / tileWidth), 0, (int)tilesPerSide - 1);
+		int y = b2Clamp((int)((p.y + height / 2) / tileHeight), 0, (int)tilesPerSide - 1);
+		return (unsigned int)(y * tilesPerSide + x);
+	};
+
+	// Bucket the points by tile, keeping them in index order within each tile
+	tileStart.assign(numTiles + 1, 0);
+	tilePoints.resize(points.size());
+	for (const b2Vec2& p : points) tileStart[tileOf(p) + 1]++;
+	for (unsigned int i = 0; i < numTiles; i++) tileStart[i + 1] += tileStart[i];
+	std::vector<unsigned int> next(tileStart.begin(), tileStart.end() - 1);
+	for (unsigned int i = 0; i < points.size(); i++) tilePoints[next[tileOf(points[i])]++] = i;
+
+	unsigned int numThreads = pool ? pool->getThreadCount() : 1;
+	while (tileScratch.size() < numThreads) tileScratch.push_back(std::unique_ptr<TileScratch>(new TileScratch()));
+	tileOutputs.resize(numTiles);
+
+	// Start with a margin of a couple of average cell widths, enough for nearly every tile when points are spread evenly
+	float32 spacing = std::sqrt(width * height / b2Max((float32)points.size(), 1.0f));
+	float32 startMargin = 2.0f * spacing;
+
+	auto buildTile = [&](unsigned int tile, unsigned int threadIndex) {
+		// Doubling the margin always ends, once it covers the whole rect the tile has every point
+		float32 margin = startMargin;
+		while (!generateTile(width, height, points, tile, margin, *tileScratch[threadIndex], tileOutputs[tile])) margin *= 2.0f;
+	};
+	if (pool) pool->parallelFor(numTiles, buildTile);
+	else for (unsigned int tile = 0; tile < numTiles; tile++) buildTile(tile, 0);
+
+	edges.clear();
+	endCorners.clear();
+	sameCorners.clear();
+	cornerViews.clear();
+	for (const TileOutput& tile : tileOutputs) {
+		edges.insert(edges.end(), tile.edges.begin(), tile.edges.end());
+		endCorners.insert(endCorners.end(), tile.endCorners.begin(), tile.endCorners.end());
+		sameCorners.insert(sameCorners.end(), tile.sameCorners.begin(), tile.sameCorners.end());
+		cornerViews.insert(cornerViews.end(), tile.views.begin(), tile.views.end());
+	}
+
+	// Both cells of an edge can be in different tiles, where they don't agree on a corner (more than three cells meeting there) both corners are the same vertex
+	std::sort(cornerViews.begin(), cornerViews.end());
+	for (unsigned int i = 1; i < cornerViews.size(); i++) {
+		const CornerView& a = cornerViews[i - 1];
+		const CornerView& b = cornerViews[i];
+		if (a.cells[0] == b.cells[0] && a.cells[1] == b.cells[1] && a.end == b.end && !(a.corner == b.corner)) {
+			sameCorners.push_back(std::make_pair(a.corner, b.corner));
+		}
+	}
 }
 
-std::vector<b2Vec2> Voronoi::genRandomPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, unsigned int numPoints)
+bool Voronoi::generateTile(float32 width, float32 height, const std::vector<b2Vec2>& points, unsigned int tile, float32 margin, TileScratch& scratch, TileOutput& out)
+{
+	jcv_rect bounds = centeredRect(width, height);
+	float32 tileWidth = width / tilesPerSide;
+	float32 tileHeight = height / tilesPerSide;
+	unsigned int tileX = tile % tilesPerSide;
+	unsigned int tileY = tile / tilesPerSide;
+
+	// The tile plus its margin, clipped to the whole diagram's rect
+	jcv_rect rect;
+	rect.min.x = b2Max(bounds.min.x + tileX * tileWidth - margin, bounds.min.x);
+	rect.min.y = b2Max(bounds.min.y + tileY * tileHeight - margin, bounds.min.y);
+	rect.max.x = b2Min(bounds.min.x + (tileX + 1) * tileWidth + margin, bounds.max.x);
+	rect.max.y = b2Min(bounds.min.y + (tileY + 1) * tileHeight + margin, bounds.max.y);
+
+	// The tile's own points first, then the points of the tiles the margin reaches into
+	scratch.points.clear();
+	scratch.indices.clear();
+	for (unsigned int i = tileStart[tile]; i < tileStart[tile + 1]; i++) {
+		scratch.points.push_back(points[tilePoints[i]]);
+		scratch.indices.push_back(tilePoints[i]);
+	}
+	int numOwnPoints = (int)scratch.points.size();
+
+	int minX = b2Max((int)((rect.min.x - bounds.min.x) / tileWidth), 0);
+	int minY = b2Max((int)((rect.min.y - bounds.min.y) / tileHeight), 0);
+	int maxX = b2Min((int)((rect.max.x - bounds.min.x) / tileWidth), (int)tilesPerSide - 1);
+	int maxY = b2Min((int)((rect.max.y - bounds.min.y) / tileHeight), (int)tilesPerSide - 1);
+	for (int y = minY; y <= maxY; y++) {
+		for (int x = minX; x <= maxX; x++) {
+			unsigned int other = y * tilesPerSide + x;
+			if (other == tile) continue;
+			for (unsigned int i = tileStart[other]; i < tileStart[other + 1]; i++) {
+				const b2Vec2& p = points[tilePoints[i]];
+				if (p.x < rect.min.x || p.x > rect.max.x || p.y < rect.min.y || p.y > rect.max.y) continue;
+				scratch.points.push_back(p);
+				scratch.indices.push_back(tilePoints[i]);
+			}
+		}
+	}
+
+	jcv_diagram diagram;
+	generateDiagram(scratch.points, rect, scratch.arena, diagram);
+	const jcv_site* sites = jcv_diagram_get_sites(&diagram);
+
+	// A cell is exact if no missing point could be closer to any part of it than its own point is. That holds if the circle
+	// around each of its corners through its point stays inside the rect (apart from the diagram's own border, nothing is missing past that)
+	for (int i = 0; i < diagram.numsites; i++) {
+		const jcv_site& site = sites[i];
+		if (site.index >= numOwnPoints) continue;
+
+		for (const jcv_graphedge* e = site.edges; e != nullptr; e = e->next) {
+			for (int end = 0; end < 2; end++) {
+				const jcv_point& corner = e->pos[end];
+				jcv_real dx = corner.x - site.p.x;
+				jcv_real dy = corner.y - site.p.y;
+				jcv_real r = std::sqrt(dx * dx + dy * dy);
+				if ((rect.min.x > bounds.min.x && corner.x - r <= rect.min.x) ||
+					(rect.min.y > bounds.min.y && corner.y - r <= rect.min.y) ||
+					(rect.max.x < bounds.max.x && corner.x + r >= rect.max.x) ||
+					(rect.max.y < bounds.max.y && corner.y + r >= rect.max.y)) {
+					jcv_diagram_free(&diagram);
+					return false;
+				}
+			}
+		}
+	}
+
+	// An edge between two cells is kept by the cell whose point comes first, so tiles sharing an edge only keep it once
+	// Its corners are as that cell sees them, unlike createDiagram the other cell's view isn't checked against it
+	out.edges.clear();
+	out.endCorners.clear();
+	out.sameCorners.clear();
+	out.views.clear();
+	for (int i = 0; i < diagram.numsites; i++) {
+		const jcv_site& site = sites[i];
+		if (site.index >= numOwnPoints) continue;
+
+		forEachCellEdge(diagram, site, scratch.indices.data(), [&](const jcv_graphedge* e, const VoronoiGraph::Corner& start, const VoronoiGraph::Corner& end) {
+			const jcv_edge* edge = e->edge;
+
+			// Both cells' views are kept, createTiledDiagram matches them up once every tile is done
+			if (e->neighbor) {
+				uint32 a = scratch.indices[site.index];
+				uint32 b = scratch.indices[e->neighbor->index];
+				// Tiles agree on edge positions exactly, so the lower end is the same one in every tile. Both ends of a zero length edge are one vertex anyway
+				const jcv_point& p0 = edge->pos[0];
+				const jcv_point& p1 = edge->pos[1];
+				uint32 startEnd = (p0.x < p1.x || (p0.x == p1.x && p0.y <= p1.y)) ? 0 : 1;
+				uint32 endEnd = jcv_point_eq(&p0, &p1) ? 0 : 1 - startEnd;
+				out.views.push_back({ { b2Min(a, b), b2Max(a, b) }, startEnd, start });
+				out.views.push_back({ { b2Min(a, b), b2Max(a, b) }, endEnd, end });
+			}
+
+			if (e->neighbor && scratch.indices[e->neighbor->index] < scratch.indices[site.index]) return;
+			if (jcv_point_eq(&edge->pos[0], &edge->pos[1])) {
+				out.sameCorners.push_back(std::make_pair(start, end));
+				return;
+			}
+			out.edges.push_back(Edge(b2Vec2((float32)edge->pos[0].x, (float32)edge->pos[0].y),
+				b2Vec2((float32)edge->pos[1].x, (float32)edge->pos[1].y)));
+			out.endCorners.push_back(start);
+			out.endCorners.push_back(end);
+		});
+	}
+
+	jcv_diagram_free(&diagram);
+	return true;
+}
+
+void Voronoi::genRandomPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, unsigned int numPoints, Random& rng, std::vector<b2Vec2>& points)
 {
-	std::vector<b2Vec2> points;
 	for (int i = 0; i < numPoints; i++) {
-		points.push_back(b2Vec2(RandomFloat(minX, maxX), RandomFloat(minY, maxY)));
+		points.push_back(b2Vec2(RandomFloat(rng, minX, maxX), RandomFloat(rng, minY, maxY)));
+	}
+}
+
+void Voronoi::genPoissonDiskPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, float32 minDistance, Random& rng, std::vector<b2Vec2>& points)
+{
+	// Attempts around each point before it is given up on, Bridson suggests 30
+	const unsigned int attempts = 30;
+
+	// Cells are small enough that each can only hold one point, so a point only needs checking against the 5x5 cells around it
+	float32 cellSize = minDistance / std::sqrt(2.0f);
+	int gridWidth = b2Max((int)std::ceil((maxX - minX) / cellSize), 1);
+	int gridHeight = b2Max((int)std::ceil((maxY - minY) / cellSize), 1);
+	poissonGrid.assign(gridWidth * gridHeight, -1);
+	activePoints.clear();
+
+	unsigned int first = (unsigned int)points.size();
+	auto cellOf = [&](const b2Vec2& p) {
+		int x = b2Min((int)((p.x - minX) / cellSize), gridWidth - 1);
+		int y = b2Min((int)((p.y - minY) / cellSize), gridHeight - 1);
+		return y * gridWidth + x;
+	};
+	auto addPoint = [&](const b2Vec2& p) {
+		poissonGrid[cellOf(p)] = (int32)(points.size() - first);
+		activePoints.push_back((unsigned int)points.size());
+		points.push_back(p);
+	};
+	auto fits = [&](const b2Vec2& p) {
+		if (p.x < minX || p.x >= maxX || p.y < minY || p.y >= maxY) return false;
+		int cell = cellOf(p);
+		int cellX = cell % gridWidth;
+		int cellY = cell / gridWidth;
+		for (int y = b2Max(cellY - 2, 0); y <= b2Min(cellY + 2, gridHeight - 1); y++) {
+			for (int x = b2Max(cellX - 2, 0); x <= b2Min(cellX + 2, gridWidth - 1); x++) {
+				int32 other = poissonGrid[y * gridWidth + x];
+				if (other >= 0 && b2DistanceSquared(p, points[first + other]) < minDistance * minDistance) return false;
+			}
+		}
+		return true;
+	};
+
+	addPoint(b2Vec2(RandomFloat(rng, minX, maxX), RandomFloat(rng, minY, maxY)));
+
+	while (!activePoints.empty()) {
+		unsigned int active = rng.nextUInt() % activePoints.size();
+		b2Vec2 centre = points[activePoints[active]];
+
+		bool found = false;
+		for (unsigned int i = 0; i < attempts && !found; i++) {
+			// Uniform over the ring between minDistance and twice that
+			float32 angle = RandomFloat(rng, 0.0f, 2.0f * b2_pi);
+			float32 radius = std::sqrt(RandomFloat(rng, minDistance * minDistance, 4.0f * minDistance * minDistance));
+			b2Vec2 candidate = centre + radius * b2Vec2(std::cos(angle), std::sin(angle));
+			if (fits(candidate)) {
+				addPoint(candidate);
+				found = true;
+			}
+		}
+
+		// Nothing more fits around this point, swap it out of the active list
+		if (!found) {
+			activePoints[active] = activePoints.back();
+			activePoints.pop_back();
+		}
 	}
-	return points;
 }
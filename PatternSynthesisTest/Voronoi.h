@@ -1,6 +1,9 @@
 #pragma once
 #include <Box2D\Box2D.h>
 #include <vector>
+#include <memory>
+
+#include "util.h"
 
 struct Edge {
 	b2Vec2 a;
@@ -9,20 +12,163 @@ struct Edge {
 	Edge(float32 aX, float32 aY, float32 bX, float32 bY) : a(aX, aY), b(bX, bY) {}
 };
 
+// Edges as a planar graph, edges that meet share one vertex instead of each repeating its coordinates
+struct VoronoiGraph {
+	struct GraphEdge {
+		unsigned int a, b; // Indices into vertices, runs from a to b like the Edge it was built from
+	};
+	// An edge touching a vertex, and the angle (radians) it leaves the vertex at
+	struct Incidence {
+		unsigned int edge;
+		float32 angle;
+	};
+	// A corner of the diagram named by the three cells around it (border sides count as cells), sorted
+	// jc_voronoi rounds a corner's position differently for each edge ending there, this is the same for all of them
+	struct Corner {
+		uint32 cells[3];
+
+		bool operator<(const Corner& other) const;
+		bool operator==(const Corner& other) const;
+	};
+
+	std::vector<b2Vec2> vertices;
+	std::vector<GraphEdge> edges; // Same order as the edges it was built from
+	// Edges touching vertex v are incidences[incidenceStart[v]] to incidences[incidenceStart[v + 1]], counter-clockwise by angle
+	std::vector<unsigned int> incidenceStart;
+	std::vector<Incidence> incidences;
+
+	// Replaces the graph with one for edges, endCorners[i * 2] and [i * 2 + 1] being the corners at edges[i].a and .b
+	// sameCorners are pairs of corners that are one vertex, the ends of edges too short to keep and corners where more than three cells meet
+	void build(const std::vector<Edge>& edges, const std::vector<Corner>& endCorners, const std::vector<std::pair<Corner, Corner>>& sameCorners);
+
+private:
+	// Kept between builds so they don't need to reallocate
+	std::vector<Corner> corners; // Every distinct corner, sorted
+	std::vector<unsigned int> parent; // Union-find of corners that are the same vertex
+	std::vector<unsigned int> cornerVertex;
+	std::vector<unsigned int> nextIncidence;
+};
+
 enum VoronoiDistributionType {
 	RANDOM,
 	UNIFORM_RANDOM,
-	UNIFORM
+	UNIFORM,
+	CENTROIDAL, // Random points moved towards their cell centroids by Lloyd relaxation, so cells come out evenly sized (see setRelaxation)
+	POISSON_DISK // Random points no closer than a minimum distance to each other, so there are no tiny cells (see setMinDistance)
 };
 
+struct ThreadPool;
+
+
+// Bump allocator for jc_voronoi's working memory
+// Everything is freed at once by reset, which keeps the memory for the next diagram, so generating
+// many diagrams with the same arena stops touching the system allocator once it has grown big enough
+struct VoronoiArena {
+
+public:
+	VoronoiArena(size_t chunkSize = 1 << 20);
+
+	VoronoiArena(const VoronoiArena&) = delete;
+	VoronoiArena& operator=(const VoronoiArena&) = delete;
+
+	// 16 byte aligned, valid until the next reset
+	void* allocate(size_t size);
+	void reset();
+
+	size_t getCapacity() const;
+
+private:
+	struct Chunk {
+		std::unique_ptr<char[]> data;
+		size_t size;
+		size_t used;
+	};
+	std::vector<Chunk> chunks;
+	unsigned int currentChunk = 0;
+	size_t chunkSize;
+
+	void addChunk(size_t size);
+};
 
 struct Voronoi {
 	std::vector<Edge> edges; // Final vector of edges, to be used for simulation
+	VoronoiGraph graph; // The same edges, with shared corners as shared vertices
+
+	Voronoi() {}
+	Voronoi(float32 width, float32 height, const std::vector<b2Vec2>& points);	// Create voronoi diagram with given points
+	Voronoi(float32 width, float32 height, unsigned int numPoints, Random& rng, VoronoiDistributionType distribType = RANDOM); // Create voronoi diagram with random points
+
+	// Same as the constructors, but replace the current diagram and reuse its memory and the arena's
+	void generate(float32 width, float32 height, const std::vector<b2Vec2>& points, VoronoiArena& arena);
+	void generate(float32 width, float32 height, unsigned int numPoints, Random& rng, VoronoiDistributionType distribType, VoronoiArena& arena);
 
-	Voronoi(float32 width, float32 height, std::vector<b2Vec2> points);	// Create voronoi diagram with given points
-	Voronoi(float32 width, float32 height, unsigned int numPoints, VoronoiDistributionType distribType = RANDOM); // Create voronoi diagram with random points
+	// Splits Lloyd relaxation and tiled generation across the pool's threads (nullptr for the calling thread only), the result is the same either way
+	// The pool is not owned by the Voronoi and must outlive it
+	void setThreadPool(ThreadPool* pool);
+
+	// Lloyd iterations run for CENTROIDAL points, each one regenerates the diagram so more is slower but more even
+	void setRelaxation(unsigned int iterations);
+
+	// Closest two POISSON_DISK points can be, 0 (the default) picks it so about numPoints points fit
+	void setMinDistance(float32 distance);
+
+	// Generates diagrams as tilesPerSide x tilesPerSide tiles, one tile per thread at a time, 1 (the default) generates the whole diagram at once
+	// Tiles overlap and grow until every cell they keep is exact, so the edges are the same as generating it at once, only in a different order
+	void setTiling(unsigned int tilesPerSide);
 
 private:
-	void createDiagram(float32 width, float32 height, std::vector<b2Vec2> points);
-	std::vector<b2Vec2> genRandomPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, unsigned int numPoints);
-};
\ No newline at end of file
+	// How one of the two cells on either side of an edge sees the corner at one end of it
+	struct CornerView {
+		uint32 cells[2]; // The edge's cells, sorted
+		uint32 end; // 0 for the end with the lower position
+		VoronoiGraph::Corner corner;
+
+		bool operator<(const CornerView& other) const;
+	};
+
+	// Edges of one tile, and their corners for the graph
+	struct TileOutput {
+		std::vector<Edge> edges;
+		std::vector<VoronoiGraph::Corner> endCorners;
+		std::vector<std::pair<VoronoiGraph::Corner, VoronoiGraph::Corner>> sameCorners;
+		std::vector<CornerView> views;
+	};
+
+	// Memory one thread reuses for every tile it generates
+	struct TileScratch {
+		VoronoiArena arena;
+		std::vector<b2Vec2> points; // The tile's own points first, then the ones around it
+		std::vector<unsigned int> indices; // Index of each of points in the full list
+	};
+
+	std::vector<b2Vec2> randomPoints; // Kept between generations so it doesn't need to reallocate
+	ThreadPool* pool = nullptr;
+	unsigned int relaxIterations = 10;
+	float32 minDistance = 0.0f;
+	std::vector<int32> poissonGrid; // Index of the point in each cell, or -1
+	std::vector<unsigned int> activePoints;
+
+	unsigned int tilesPerSide = 1;
+	std::vector<std::unique_ptr<TileScratch>> tileScratch; // One per thread
+	std::vector<unsigned int> tileStart; // Points of tile i are tilePoints[tileStart[i]] to tilePoints[tileStart[i + 1]]
+	std::vector<unsigned int> tilePoints;
+	std::vector<TileOutput> tileOutputs;
+
+	// Corners for graph, see VoronoiGraph::build
+	std::vector<VoronoiGraph::Corner> endCorners;
+	std::vector<std::pair<VoronoiGraph::Corner, VoronoiGraph::Corner>> sameCorners;
+	std::vector<std::pair<const void*, unsigned int>> edgeOrder; // jc_voronoi edge and its index in edges
+	std::vector<CornerView> cornerViews;
+
+	// Moves every point to the centroid of its cell, iterations times
+	void relax(float32 width, float32 height, std::vector<b2Vec2>& points, VoronoiArena& arena);
+
+	void createDiagram(float32 width, float32 height, const std::vector<b2Vec2>& points, VoronoiArena& arena);
+	void createTiledDiagram(float32 width, float32 height, const std::vector<b2Vec2>& points);
+	// Returns false if the margin around the tile was too small for its cells to be exact
+	bool generateTile(float32 width, float32 height, const std::vector<b2Vec2>& points, unsigned int tile, float32 margin, TileScratch& scratch, TileOutput& out);
+	// Appends numPoints random points to points
+	void genRandomPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, unsigned int numPoints, Random& rng, std::vector<b2Vec2>& points);
+	// Appends points no closer than minDistance to each other until no more fit (Bridson's algorithm)
+	void genPoissonDiskPoints(float32 minX, float32 maxX, float32 minY, float32 maxY, float32 minDistance, Random& rng, std::vector<b2Vec2>& points);
+};
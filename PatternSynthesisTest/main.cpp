@@ -10,6 +10,9 @@
 
 #include "Voronoi.h"
 #include "Springs.h"
+#include "Patterns.h"
+#include "Batch.h"
+#include "EdgeRenderer.h"
 
 // IDEAS: 
 //createSpringLine takes two angles to lerp between, angles could be determined by angle of intersecting bodies
@@ -39,28 +42,14 @@ void drawPolygonShape(b2Body* body, b2PolygonShape* shape, sf::RenderWindow* win
 	window->draw(cShape);
 }
 
-void drawEdges(std::vector<Edge> edges, sf::RenderWindow* window) {
-	
-	for (Edge e : edges) {
-		unsigned int windowWidth = window->getSize().x;
-		unsigned int windowHeight = window->getSize().y;
-		e.a.x = (e.a.x * SCALE) + windowWidth / 2;
-		e.a.y = (e.a.y * SCALE) + windowHeight / 2;
-		e.b.x = (e.b.x * SCALE) + windowWidth / 2;
-		e.b.y = (e.b.y * SCALE) + windowHeight / 2;
-		
-
-		sf::Vertex line[] = {
-			sf::Vertex(sf::Vector2f(e.a.x, e.a.y), sf::Color::Black),
-			sf::Vertex(sf::Vector2f(e.b.x, e.b.y), sf::Color::Black)
-		};
-		window->draw(line, 2, sf::Lines);
-	}
-}
+void drawBodies(SpringWorld& sWorld, sf::RenderWindow* window) {
+	// Spring sections have mass but no fixture, draw them as the box their mass comes from
+	b2PolygonShape sectionShape;
+	sectionShape.SetAsBox(0.15f, 0.15f);
 
-void drawBodies(SpringWorld sWorld, sf::RenderWindow* window) {
 	for (b2Body* bodyIt = sWorld.getWorld()->GetBodyList(); bodyIt != nullptr; bodyIt = bodyIt->GetNext()) {
 		b2Fixture* f = bodyIt->GetFixtureList();
+		if (f == NULL) drawPolygonShape(bodyIt, &sectionShape, window);
 
 		while (f != NULL) {
 			b2Shape::Type shapeType = f->GetType();
@@ -133,6 +122,8 @@ void decidePatternToCreate(SpringWorld* sWorld, unsigned int screenWidth, unsign
 		std::cout << "Press [6] for randomized fractal tree diagram." << std::endl;
 		std::cout << "Press [7] for uniformly random Voronoi diagram." << std::endl;
 		std::cout << "Press [8] for uniform grid." << std::endl;
+		std::cout << "Press [9] for centroidal (evenly spaced) Voronoi diagram." << std::endl;
+		std::cout << "Press [10] for Poisson-disk (no tiny cells) Voronoi diagram." << std::endl;
 		
 		std::cout << std::endl;
 
@@ -142,199 +133,60 @@ void decidePatternToCreate(SpringWorld* sWorld, unsigned int screenWidth, unsign
 		std::cout << "Press [d] for dried mud cracks-esque diagram." << std::endl;
 		std::cout << "Press [e] for consecutive sine waves diagram." << std::endl;
 
-		char input;
+		std::string input;
 		std::cin >> input;
 		
-		switch (input) {
-		case '1':
-		{
-			unsigned int springs = 0;
-			RASF_TYPE type;
-			float32 restAngle = 0.0f;
-
-			std::cout << "Springs in line?" << std::endl;
-			std::cin >> springs;
-
-			std::cout << "Rest angle? (in degrees)" << std::endl;
-			std::cin >> restAngle;
-
-			std::cout << "Creating line." << std::endl;
-			sWorld->createSpringLine(b2Vec2(-10.0f, 0.0f), b2Vec2(10.0f, 0.0f), springs, getSequentialSinRASF(restAngle));
-			sWorld->initSpringWorld();
-		}
-			return;
-		case '2':
-		{
-			unsigned int sideSprings = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Springs per side?" << std::endl;
-			std::cin >> sideSprings;
-			
-			type = decideRASFType();
-
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			std::cout << "Creating box." << std::endl;
-			sWorld->createSpringBox(sideSprings, type, rasfValue);
-		}
-			return;
-		case '3':
-		{
-			unsigned int sideSprings = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Springs per side?" << std::endl;
-			std::cin >> sideSprings;
-			
-			type = decideRASFType();
-			
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			std::cout << "Creating test squiggle." << std::endl;
-			sWorld->createSquiggle(sideSprings, type, rasfValue);
-
-			return;
-		}
-		case '4':
-		{
-			unsigned int numPoints = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Number of points in Voronoi diagram?" << std::endl;
-			std::cin >> numPoints;
-			
-			type = decideRASFType();
-			
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			std::cout << "Creating Voronoi diagram." << std::endl;
-			
-			Voronoi v(screenWidth * INVSCALE, screenHeight * INVSCALE, numPoints, RANDOM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, type, rasfValue);
-		}
-			return;
-		case '5':
-		{
-			unsigned int fractalDepth = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Fractal depth?" << std::endl;
-			std::cin >> fractalDepth;
-
-			type = decideRASFType();
-
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
+		PatternSettings settings;
 
-			sWorld->createFractalTree(fractalDepth, type, rasfValue);
-		}
-			return;	
-		case '6':
-		{
-			unsigned int fractalDepth = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Fractal depth?" << std::endl;
-			std::cin >> fractalDepth;
-
-			type = decideRASFType();
-
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			sWorld->createRandomizedFractalTree(fractalDepth, type, rasfValue);
-		}
-			return;
-		case '7':
-		{
-			unsigned int numPoints = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Number of points in Voronoi diagram?" << std::endl;
-			std::cin >> numPoints;
-
-			type = decideRASFType();
-
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			std::cout << "Creating Voronoi diagram." << std::endl;
-
-			Voronoi v(screenWidth* INVSCALE, screenHeight* INVSCALE, numPoints, UNIFORM_RANDOM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, type, rasfValue);
-		}
-			return;
-		case '8':
-		{
-			unsigned int numPoints = 0;
-			RASF_TYPE type;
-			float32 rasfValue = 0.0f;
-
-			std::cout << "Size of one side of grid?" << std::endl;
-			std::cin >> numPoints;
-
-			type = decideRASFType();
-
-			std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
-			std::cin >> rasfValue;
-
-			std::cout << "Creating Voronoi diagram." << std::endl;
+		if (parsePatternType(input, settings.type)) {
+			switch (settings.type) {
+			case PATTERN_LINE:
+				std::cout << "Springs in line?" << std::endl;
+				break;
+			case PATTERN_BOX:
+			case PATTERN_SQUIGGLE:
+				std::cout << "Springs per side?" << std::endl;
+				break;
+			case PATTERN_VORONOI:
+			case PATTERN_UNIFORM_RANDOM_VORONOI:
+			case PATTERN_CENTROIDAL_VORONOI:
+			case PATTERN_POISSON_VORONOI:
+				std::cout << "Number of points in Voronoi diagram?" << std::endl;
+				break;
+			case PATTERN_FRACTAL_TREE:
+			case PATTERN_RANDOMIZED_FRACTAL_TREE:
+				std::cout << "Fractal depth?" << std::endl;
+				break;
+			case PATTERN_UNIFORM_GRID:
+				std::cout << "Size of one side of grid?" << std::endl;
+				break;
+			}
+			std::cin >> settings.size;
 
-			Voronoi v(screenWidth* INVSCALE, screenHeight * INVSCALE, numPoints * numPoints, UNIFORM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, type, rasfValue);
-		}
-			return;
-		case 'a':
-		{
-			Voronoi v(screenWidth* INVSCALE, screenHeight * INVSCALE, 100, RANDOM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, RASF_BASIC_LERP, 1.0f);
-		}
-			return;
-		case 'b':
-		{
-			sWorld->createRandomizedFractalTree(7, RASF_RANDOMIZED, 2.0f);
-		}
-			return;
-		case 'c':
-		{
-			Voronoi v(screenWidth* INVSCALE, screenHeight * INVSCALE, 10 * 10, UNIFORM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, RASF_CONSTANT, 10.0f);
-		}
-			return;
-		case 'd':
-		{
-			Voronoi v(screenWidth* INVSCALE, screenHeight * INVSCALE, 100, UNIFORM_RANDOM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, RASF_PSEUDORANDOM, 1.0f);
-		}
-			return;
-		case 'e':
-		{
-			Voronoi v(screenWidth* INVSCALE, screenHeight* INVSCALE, 40, UNIFORM_RANDOM);
-			Border b((-(int)screenWidth / 2.0f), (-(int)screenHeight / 2.0f), ((int)screenWidth / 2.0f), ((int)screenHeight / 2.0f));
-			sWorld->createSystem(b, v.edges, RASF_SEQUENTIAL_SIN, 1.0f);
+			if (settings.type == PATTERN_LINE) {
+				std::cout << "Rest angle? (in degrees)" << std::endl;
+				std::cin >> settings.rasfValue;
+				settings.rasfType = RASF_SEQUENTIAL_SIN;
+			}
+			else {
+				settings.rasfType = decideRASFType();
 
+				std::cout << "RASF value? (either a multiplier value, or an angle in degrees)" << std::endl;
+				std::cin >> settings.rasfValue;
+			}
 		}
-			return;
-		default:
+		else if (input == "a") settings = { PATTERN_VORONOI, 100, RASF_BASIC_LERP, 1.0f };
+		else if (input == "b") settings = { PATTERN_RANDOMIZED_FRACTAL_TREE, 7, RASF_RANDOMIZED, 2.0f };
+		else if (input == "c") settings = { PATTERN_UNIFORM_GRID, 10, RASF_CONSTANT, 10.0f };
+		else if (input == "d") settings = { PATTERN_UNIFORM_RANDOM_VORONOI, 100, RASF_PSEUDORANDOM, 1.0f };
+		else if (input == "e") settings = { PATTERN_UNIFORM_RANDOM_VORONOI, 40, RASF_SEQUENTIAL_SIN, 1.0f };
+		else {
 			std::cout << "Incorrect input." << std::endl;
-			break;
+			continue;
 		}
+
+		createPattern(sWorld, settings, screenWidth, screenHeight);
+		return;
 	}
 
 }
@@ -342,15 +194,35 @@ void decidePatternToCreate(SpringWorld* sWorld, unsigned int screenWidth, unsign
 void printHelpText() {
 	std::cout << "Press [p] to play/pause." << std::endl;
 	std::cout << "Press [SPACE] to show bodies." << std::endl;
+	std::cout << "Press [T] to toggle thick lines." << std::endl;
 	std::cout << "Press [ENTER] to save image." << std::endl;
 }
 
-int main() {
-	srand(time(0));
+int main(int argc, char* argv[]) {
+	// Any command line options mean a headless batch run, no window or console prompts
+	if (argc > 1) {
+		BatchJob job;
+		if (!parseBatchArgs(argc, argv, job)) {
+			printBatchUsage();
+			return 1;
+		}
+		return runBatch(job) ? 0 : 1;
+	}
 
 	// Create world, without gravity
 	b2Vec2 gravity(0.0f, 0.0f);
-	SpringWorld sWorld(new b2World(gravity));
+	// Printed so an interesting pattern can be reproduced with --seed
+	unsigned int seed = (unsigned int)time(0);
+	std::cout << "Seed: " << seed << std::endl;
+	SpringWorld sWorld(new b2World(gravity), seed);
+
+	ThreadPool threadPool;
+	sWorld.setThreadPool(&threadPool);
+
+	// Stop stepping once nothing moves visibly any more (0.01 m/s is a third of a pixel per second)
+	ConvergenceCriteria settle;
+	settle.maxSpeed = 0.01f;
+	sWorld.setConvergenceCriteria(settle);
 	
 	unsigned int screenWidth = 1000;
 	unsigned int screenHeight = 1000;
@@ -367,16 +239,22 @@ int main() {
 	
 	printHelpText();
 		
+	EdgeRenderer edgeRenderer;
+
 	bool playing = false;
 	bool drawB = false;
 	while (window.isOpen()) {
 
-		if (playing) sWorld.update(1.0f / 60.0f);
+		if (playing && !sWorld.hasConverged()) {
+			sWorld.update(1.0f / 60.0f);
+			if (sWorld.hasConverged()) std::cout << "Pattern settled after " << sWorld.getStepCount() << " steps." << std::endl;
+		}
 		
 		window.clear(sf::Color::White);
 		// Render things
 
-		drawEdges(sWorld.getSpringEdges(), &window);
+		edgeRenderer.update(sWorld, window.getSize());
+		window.draw(edgeRenderer);
 		if (drawB) drawBodies(sWorld, &window);
 		
 		sf::Event event;
@@ -396,6 +274,9 @@ int main() {
 				case sf::Keyboard::Space:
 					drawB = !drawB;
 					break;
+				case sf::Keyboard::T:
+					edgeRenderer.setMode(edgeRenderer.getMode() == EDGE_RENDER_LINES ? EDGE_RENDER_QUADS : EDGE_RENDER_LINES);
+					break;
 				case sf::Keyboard::Enter:
 					std::string filename;
 					std::cout << "Save image as:" << std::endl;
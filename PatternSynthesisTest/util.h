@@ -1,8 +1,45 @@
 #pragma once
 #include <Box2D\Box2D.h>
 
-inline float32 RandomFloat(float32 a, float32 b) {
-	float32 random = ((float32)rand()) / (float32)RAND_MAX;
+#include <cstdint>
+
+// Small, fast PRNG (PCG32) with its own state, so patterns are reproducible from a seed and
+// can be generated on several threads at once. Copying one gives a generator that repeats the same numbers
+struct Random {
+	uint64_t state = 0;
+	uint64_t inc = 1;
+
+	// Generators with the same seed but a different stream give unrelated sequences
+	Random(uint64_t seed = 0, uint64_t stream = 0) {
+		inc = (stream << 1) | 1;
+		nextUInt();
+		state += seed;
+		nextUInt();
+	}
+
+	uint32_t nextUInt() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + inc;
+		uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rot = (uint32_t)(old >> 59);
+		return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+	}
+
+	// In [0, 1)
+	float32 nextFloat() {
+		return (float32)(nextUInt() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// New independent generator seeded from this one, e.g. one per spring line
+	Random split() {
+		uint64_t seed = nextUInt();
+		seed = (seed << 32) | nextUInt();
+		return Random(seed, nextUInt());
+	}
+};
+
+inline float32 RandomFloat(Random& rng, float32 a, float32 b) {
+	float32 random = rng.nextFloat();
 	float32 diff = b - a;
 	float32 r = random * diff;
 	return a + r;
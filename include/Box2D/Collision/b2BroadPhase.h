@@ -49,6 +49,11 @@ public:
 	/// UpdatePairs is called.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create count proxies at once, building the tree in one pass instead of
+	/// inserting them one by one. proxyIds receives the id of each proxy, in order.
+	/// Pairs are not reported until UpdatePairs is called.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
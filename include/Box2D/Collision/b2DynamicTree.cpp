@@ -18,6 +18,7 @@
 
 #include "Box2D/Collision/b2DynamicTree.h"
 #include <string.h>
+#include <algorithm>
 
 b2DynamicTree::b2DynamicTree()
 {
@@ -58,22 +59,7 @@ int32 b2DynamicTree::AllocateNode()
 		b2Assert(m_nodeCount == m_nodeCapacity);
 
 		// The free list is empty. Rebuild a bigger pool.
-		b2TreeNode* oldNodes = m_nodes;
-		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
-		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
-
-		// Build a linked list for the free list. The parent
-		// pointer becomes the "next" pointer.
-		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
-		{
-			m_nodes[i].next = i + 1;
-			m_nodes[i].height = -1;
-		}
-		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
-		m_nodes[m_nodeCapacity-1].height = -1;
-		m_freeList = m_nodeCount;
+		GrowPool(m_nodeCapacity * 2);
 	}
 
 	// Peel a node off the free list.
@@ -88,6 +74,40 @@ int32 b2DynamicTree::AllocateNode()
 	return nodeId;
 }
 
+// Grow the pool to the given capacity, the new nodes go to the front of the free list.
+void b2DynamicTree::GrowPool(int32 capacity)
+{
+	b2Assert(capacity > m_nodeCapacity);
+
+	b2TreeNode* oldNodes = m_nodes;
+	int32 oldCapacity = m_nodeCapacity;
+	m_nodeCapacity = capacity;
+	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	memcpy(m_nodes, oldNodes, oldCapacity * sizeof(b2TreeNode));
+	b2Free(oldNodes);
+
+	// Build a linked list for the free list. The parent
+	// pointer becomes the "next" pointer.
+	for (int32 i = oldCapacity; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = m_freeList;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_freeList = oldCapacity;
+}
+
+void b2DynamicTree::Reserve(int32 proxyCount)
+{
+	// Every leaf but the first brings one internal node with it.
+	int32 capacity = m_nodeCount + 2 * proxyCount;
+	if (capacity > m_nodeCapacity)
+	{
+		GrowPool(capacity);
+	}
+}
+
 // Return a node to the pool.
 void b2DynamicTree::FreeNode(int32 nodeId)
 {
@@ -118,6 +138,32 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	Reserve(count);
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+
+		// Fatten the aabb.
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+
+		proxyIds[i] = proxyId;
+	}
+
+	RebuildTopDown();
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -769,6 +815,85 @@ void b2DynamicTree::RebuildBottomUp()
 	Validate();
 }
 
+void b2DynamicTree::RebuildTopDown()
+{
+	// Centers are kept next to the node ids so partitioning doesn't jump around the pool.
+	b2TreeLeaf* leaves = (b2TreeLeaf*)b2Alloc(m_nodeCount * sizeof(b2TreeLeaf));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count].center = m_nodes[i].aabb.GetCenter();
+			leaves[count].node = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = count > 0 ? BuildTopDown(leaves, count) : b2_nullNode;
+	b2Free(leaves);
+}
+
+int32 b2DynamicTree::BuildTopDown(b2TreeLeaf* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0].node;
+	}
+
+	// Split at the median center along the axis the centers are spread out most.
+	b2Vec2 lower = leaves[0].center;
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, leaves[i].center);
+		upper = b2Max(upper, leaves[i].center);
+	}
+	b2Vec2 extent = upper - lower;
+
+	int32 half = count / 2;
+	if (extent.x >= extent.y)
+	{
+		std::nth_element(leaves, leaves + half, leaves + count, [](const b2TreeLeaf& a, const b2TreeLeaf& b) { return a.center.x < b.center.x; });
+	}
+	else
+	{
+		std::nth_element(leaves, leaves + half, leaves + count, [](const b2TreeLeaf& a, const b2TreeLeaf& b) { return a.center.y < b.center.y; });
+	}
+
+	int32 index1 = BuildTopDown(leaves, half);
+	int32 index2 = BuildTopDown(leaves + half, count - half);
+
+	// The pool was reserved up front, but nodes are still addressed by index in case it grew.
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	b2TreeNode* child1 = m_nodes + index1;
+	b2TreeNode* child2 = m_nodes + index2;
+	parent->child1 = index1;
+	parent->child2 = index2;
+	parent->height = 1 + b2Max(child1->height, child2->height);
+	parent->aabb.Combine(child1->aabb, child2->aabb);
+	parent->parent = b2_nullNode;
+
+	child1->parent = parentIndex;
+	child2->parent = parentIndex;
+
+	return parentIndex;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
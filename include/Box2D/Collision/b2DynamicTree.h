@@ -50,6 +50,13 @@ struct b2TreeNode
 	int32 height;
 };
 
+/// A leaf and the center of its AABB, used while building the tree top-down.
+struct b2TreeLeaf
+{
+	b2Vec2 center;
+	int32 node;
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -70,9 +77,17 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create count proxies at once. The new leaves are not inserted one at a time, the
+	/// whole tree is rebuilt top-down instead (see RebuildTopDown), which is much faster
+	/// for large batches. proxyIds receives the id of each proxy, in order.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
+	/// Grow the node pool so proxyCount more proxies fit without reallocating.
+	void Reserve(int32 proxyCount);
+
 	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
 	/// then the proxy is removed from the tree and re-inserted. Otherwise
 	/// the function returns immediately.
@@ -118,6 +133,10 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build a balanced tree by splitting the leaves in half along the longest axis of
+	/// their centers, recursively. O(n log n), not as tight as RebuildBottomUp.
+	void RebuildTopDown();
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -127,6 +146,10 @@ private:
 
 	int32 AllocateNode();
 	void FreeNode(int32 node);
+	void GrowPool(int32 capacity);
+
+	// Builds a subtree over leaves [0, count) and returns its root. Reorders leaves.
+	int32 BuildTopDown(b2TreeLeaf* leaves, int32 count);
 
 	void InsertLeaf(int32 node);
 	void RemoveLeaf(int32 node);
@@ -44,16 +44,26 @@ public:
 	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
+	/// Make sure at least count blocks of the given size can be allocated without
+	/// adding chunks. Does nothing if size is larger than b2_maxBlockSize.
+	void Reserve(int32 size, int32 count);
+
 	void Clear();
 
 private:
 
+	/// Add a chunk of blocks for size class index to the front of its free list.
+	void AddChunk(int32 index);
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	/// Fill in s_blockSizeLookup. Called once during static initialization.
+	static bool InitializeBlockSizeLookup();
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
@@ -20,28 +20,26 @@
 
 #if defined(_WIN32)
 
-float64 b2Timer::s_invFrequency = 0.0f;
-
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 
 #include <windows.h>
 
-b2Timer::b2Timer()
+// Queried during static initialization so timers can be created on several threads at once.
+static float64 b2QueryInvFrequency()
 {
 	LARGE_INTEGER largeInteger;
+	QueryPerformanceFrequency(&largeInteger);
+	float64 frequency = float64(largeInteger.QuadPart);
+	return frequency > 0.0f ? 1000.0f / frequency : 0.0f;
+}
 
-	if (s_invFrequency == 0.0f)
-	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
-		if (s_invFrequency > 0.0f)
-		{
-			s_invFrequency = 1000.0f / s_invFrequency;
-		}
-	}
+float64 b2Timer::s_invFrequency = b2QueryInvFrequency();
 
+b2Timer::b2Timer()
+{
+	LARGE_INTEGER largeInteger;
 	QueryPerformanceCounter(&largeInteger);
 	m_start = float64(largeInteger.QuadPart);
 }
@@ -35,7 +35,10 @@
 #include "Box2D/Dynamics/b2World.h"
 
 b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
-bool b2Contact::s_initialized = false;
+
+// Registered during static initialization rather than by the first contact,
+// so worlds on several threads never race to fill in the table.
+bool b2Contact::s_initialized = (b2Contact::InitializeRegisters(), true);
 
 void b2Contact::InitializeRegisters()
 {
@@ -68,11 +71,7 @@ void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* dest
 
 b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
 {
-	if (s_initialized == false)
-	{
-		InitializeRegisters();
-		s_initialized = true;
-	}
+	b2Assert(s_initialized == true);
 
 	b2Shape::Type type1 = fixtureA->GetType();
 	b2Shape::Type type2 = fixtureB->GetType();
@@ -28,6 +28,7 @@
 #include "Box2D/Dynamics/Joints/b2FrictionJoint.h"
 #include "Box2D/Dynamics/Joints/b2RopeJoint.h"
 #include "Box2D/Dynamics/Joints/b2MotorJoint.h"
+#include "Box2D/Dynamics/Joints/b2SpringJoint.h"
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2World.h"
 #include "Box2D/Common/b2BlockAllocator.h"
@@ -117,6 +118,13 @@ b2Joint* b2Joint::Create(const b2JointDef* def, b2BlockAllocator* allocator)
 		}
 		break;
 
+	case e_springJoint:
+		{
+			void* mem = allocator->Allocate(sizeof(b2SpringJoint));
+			joint = new (mem) b2SpringJoint(static_cast<const b2SpringJointDef*>(def));
+		}
+		break;
+
 	default:
 		b2Assert(false);
 		break;
@@ -125,6 +133,40 @@ b2Joint* b2Joint::Create(const b2JointDef* def, b2BlockAllocator* allocator)
 	return joint;
 }
 
+int32 b2Joint::GetSize(b2JointType type)
+{
+	switch (type)
+	{
+	case e_distanceJoint:
+		return sizeof(b2DistanceJoint);
+	case e_mouseJoint:
+		return sizeof(b2MouseJoint);
+	case e_prismaticJoint:
+		return sizeof(b2PrismaticJoint);
+	case e_revoluteJoint:
+		return sizeof(b2RevoluteJoint);
+	case e_pulleyJoint:
+		return sizeof(b2PulleyJoint);
+	case e_gearJoint:
+		return sizeof(b2GearJoint);
+	case e_wheelJoint:
+		return sizeof(b2WheelJoint);
+	case e_weldJoint:
+		return sizeof(b2WeldJoint);
+	case e_frictionJoint:
+		return sizeof(b2FrictionJoint);
+	case e_ropeJoint:
+		return sizeof(b2RopeJoint);
+	case e_motorJoint:
+		return sizeof(b2MotorJoint);
+	case e_springJoint:
+		return sizeof(b2SpringJoint);
+	default:
+		b2Assert(false);
+		return 0;
+	}
+}
+
 void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 {
 	joint->~b2Joint();
@@ -174,6 +216,10 @@ void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 		allocator->Free(joint, sizeof(b2MotorJoint));
 		break;
 
+	case e_springJoint:
+		allocator->Free(joint, sizeof(b2SpringJoint));
+		break;
+
 	default:
 		b2Assert(false);
 		break;
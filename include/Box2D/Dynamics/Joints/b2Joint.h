@@ -39,7 +39,8 @@ enum b2JointType
     e_weldJoint,
 	e_frictionJoint,
 	e_ropeJoint,
-	e_motorJoint
+	e_motorJoint,
+	e_springJoint
 };
 
 enum b2LimitState
@@ -158,6 +159,9 @@ protected:
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
 
+	// Size of the joint class allocated for the given type.
+	static int32 GetSize(b2JointType type);
+
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
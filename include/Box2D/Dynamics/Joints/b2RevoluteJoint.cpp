@@ -28,6 +28,14 @@
 // Identity used:
 // w k % (rx i + ry j) = w * (-ry i + rx j)
 
+// Soft point-to-point constraint (frequencyHz > 0)
+// The constraint is a stiff spring solved implicitly, with
+// omega = 2 * pi * frequencyHz, zeta = dampingRatio and h = dt:
+// biasRate = omega / (2 * zeta + h * omega)
+// massScale = h * omega * (2 * zeta + h * omega) / (1 + h * omega * (2 * zeta + h * omega))
+// impulseScale = 1 / (1 + h * omega * (2 * zeta + h * omega))
+// impulse = -massScale * inv(K) * (Cdot + biasRate * C) - impulseScale * accumulatedImpulse
+
 // Motor constraint
 // Cdot = w2 - w1
 // J = [0 0 -1 0 0 1]
@@ -59,6 +67,12 @@ b2RevoluteJoint::b2RevoluteJoint(const b2RevoluteJointDef* def)
 	m_enableLimit = def->enableLimit;
 	m_enableMotor = def->enableMotor;
 	m_limitState = e_inactiveLimit;
+
+	m_frequencyHz = def->frequencyHz;
+	m_dampingRatio = def->dampingRatio;
+	m_softBias.SetZero();
+	m_softMassScale = 1.0f;
+	m_softImpulseScale = 0.0f;
 }
 
 void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
@@ -72,10 +86,12 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 	m_invIA = m_bodyA->m_invI;
 	m_invIB = m_bodyB->m_invI;
 
+	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
 	b2Vec2 vA = data.velocities[m_indexA].v;
 	float32 wA = data.velocities[m_indexA].w;
 
+	b2Vec2 cB = data.positions[m_indexB].c;
 	float32 aB = data.positions[m_indexB].a;
 	b2Vec2 vB = data.velocities[m_indexB].v;
 	float32 wB = data.velocities[m_indexB].w;
@@ -120,6 +136,20 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_motorImpulse = 0.0f;
 	}
 
+	if (m_frequencyHz > 0.0f)
+	{
+		float32 h = data.step.dt;
+		float32 omega = 2.0f * b2_pi * m_frequencyHz;
+		float32 a1 = 2.0f * m_dampingRatio + h * omega;
+		float32 a2 = h * omega * a1;
+		float32 a3 = 1.0f / (1.0f + a2);
+
+		b2Vec2 C = cB + m_rB - cA - m_rA;
+		m_softBias = (omega / a1) * C;
+		m_softMassScale = a2 * a3;
+		m_softImpulseScale = a3;
+	}
+
 	if (m_enableLimit && fixedRotation == false)
 	{
 		float32 jointAngle = aB - aA - m_referenceAngle;
@@ -270,7 +300,16 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2SolverData& data)
 	{
 		// Solve point-to-point constraint
 		b2Vec2 Cdot = vB + b2Cross(wB, m_rB) - vA - b2Cross(wA, m_rA);
-		b2Vec2 impulse = m_mass.Solve22(-Cdot);
+		b2Vec2 impulse;
+		if (m_frequencyHz > 0.0f)
+		{
+			b2Vec2 accumulated(m_impulse.x, m_impulse.y);
+			impulse = -m_softMassScale * m_mass.Solve22(Cdot + m_softBias) - m_softImpulseScale * accumulated;
+		}
+		else
+		{
+			impulse = m_mass.Solve22(-Cdot);
+		}
 
 		m_impulse.x += impulse.x;
 		m_impulse.y += impulse.y;
@@ -338,7 +377,8 @@ bool b2RevoluteJoint::SolvePositionConstraints(const b2SolverData& data)
 		aB += m_invIB * limitImpulse;
 	}
 
-	// Solve point-to-point constraint.
+	// Solve point-to-point constraint. A soft one pulls itself together in the velocity solver.
+	if (m_frequencyHz == 0.0f)
 	{
 		qA.Set(aA);
 		qB.Set(aB);
@@ -46,6 +46,8 @@ struct b2RevoluteJointDef : public b2JointDef
 		motorSpeed = 0.0f;
 		enableLimit = false;
 		enableMotor = false;
+		frequencyHz = 0.0f;
+		dampingRatio = 1.0f;
 	}
 
 	/// Initialize the bodies, anchors, and reference angle using a world
@@ -79,6 +81,15 @@ struct b2RevoluteJointDef : public b2JointDef
 	/// The maximum motor torque used to achieve the desired motor speed.
 	/// Usually in N-m.
 	float32 maxMotorTorque;
+
+	/// Makes the point-to-point constraint soft, like a very stiff spring with
+	/// this natural frequency. Drift is then pulled back by the velocity solver
+	/// instead of the position solver, which suits many small time steps with
+	/// few iterations each. 0 (the default) keeps the constraint rigid.
+	float32 frequencyHz;
+
+	/// The damping ratio of the soft point-to-point constraint. 0 = no damping, 1 = critical damping.
+	float32 dampingRatio;
 };
 
 /// A revolute joint constrains two bodies to share a common point while they
@@ -170,6 +181,8 @@ protected:
 	b2Vec2 m_localAnchorB;
 	b2Vec3 m_impulse;
 	float32 m_motorImpulse;
+	float32 m_frequencyHz;
+	float32 m_dampingRatio;
 
 	bool m_enableMotor;
 	float32 m_maxMotorTorque;
@@ -192,6 +205,9 @@ protected:
 	float32 m_invIA;
 	float32 m_invIB;
 	b2Mat33 m_mass;			// effective mass for point-to-point constraint.
+	b2Vec2 m_softBias;		// velocity the soft point-to-point constraint pulls the anchors together at.
+	float32 m_softMassScale;
+	float32 m_softImpulseScale;
 	float32 m_motorMass;	// effective mass for motor/limit angular constraint.
 	b2LimitState m_limitState;
 };
@@ -0,0 +1,270 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/Joints/b2SpringJoint.h"
+#include "Box2D/Dynamics/b2Body.h"
+#include "Box2D/Dynamics/b2TimeStep.h"
+
+// Both parts are soft constraints, solved like the soft b2DistanceJoint
+// but with the stiffness k and damping d given directly:
+// gamma = 1 / (h * (d + h * k)), bias = C * h * k * gamma
+// impulse = -1 / (K + gamma) * (Cdot + bias + gamma * accumulatedImpulse)
+
+// Linear part
+// C = norm(cB - cA) - L
+// u = (cB - cA) / norm(cB - cA)
+// J = [-u u 0]
+// K = invMassA + invMassB
+
+// Angular part, the corner at A between C and B
+// p = cA - cC, q = cA - cB
+// C = atan2(cross(p, q), dot(p, q)) - angle
+// J = [gA gB gC], gC = perp(p) / |p|^2, gB = -perp(q) / |q|^2, gA = -gB - gC
+// K = invMassA * |gA|^2 + invMassB * |gB|^2 + invMassC * |gC|^2
+
+// Angle from p to q, counter-clockwise in [0, 2 * pi)
+static float32 b2CornerAngle(const b2Vec2& p, const b2Vec2& q)
+{
+	float32 angle = atan2f(b2Cross(p, q), b2Dot(p, q));
+	if (angle < 0.0f)
+	{
+		angle += 2.0f * b2_pi;
+	}
+	return angle;
+}
+
+// Soft constraint coefficients, see above. Returns the effective mass
+static float32 b2SoftMass(float32 invMass, float32 C, float32 k, float32 d, float32 h, float32* gamma, float32* bias)
+{
+	*gamma = h * (d + h * k);
+	*gamma = *gamma != 0.0f ? 1.0f / *gamma : 0.0f;
+	*bias = C * h * k * *gamma;
+
+	invMass += *gamma;
+	return invMass != 0.0f ? 1.0f / invMass : 0.0f;
+}
+
+void b2SpringJointDef::Initialize(b2Body* bC, b2Body* bA, b2Body* bB)
+{
+	bodyA = bA;
+	bodyB = bB;
+	bodyC = bC;
+
+	b2Vec2 cA = bodyA->GetWorldCenter();
+	b2Vec2 cB = bodyB->GetWorldCenter();
+	length = b2Distance(cA, cB);
+	if (bodyC)
+	{
+		angle = b2CornerAngle(cA - bodyC->GetWorldCenter(), cA - cB);
+	}
+}
+
+b2SpringJoint::b2SpringJoint(const b2SpringJointDef* def)
+: b2Joint(def)
+{
+	m_bodyC = def->bodyC;
+	m_length = def->length;
+	m_stiffness = def->stiffness;
+	m_damping = def->damping;
+	m_angle = def->angle;
+	m_angularStiffness = def->angularStiffness;
+	m_angularDamping = def->angularDamping;
+
+	m_impulse = 0.0f;
+	m_angularImpulse = 0.0f;
+	m_indexC = -1;
+	m_invMassC = 0.0f;
+	m_gamma = 0.0f;
+	m_bias = 0.0f;
+	m_mass = 0.0f;
+	m_angularGamma = 0.0f;
+	m_angularBias = 0.0f;
+	m_angularMass = 0.0f;
+}
+
+void b2SpringJoint::InitVelocityConstraints(const b2SolverData& data)
+{
+	m_indexA = m_bodyA->m_islandIndex;
+	m_indexB = m_bodyB->m_islandIndex;
+	m_invMassA = m_bodyA->m_invMass;
+	m_invMassB = m_bodyB->m_invMass;
+
+	b2Vec2 cA = data.positions[m_indexA].c;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	b2Vec2 cB = data.positions[m_indexB].c;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+
+	float32 h = data.step.dt;
+
+	// Linear part
+	m_u = cB - cA;
+	float32 length = m_u.Length();
+	if (length > b2_linearSlop && m_stiffness > 0.0f)
+	{
+		m_u *= 1.0f / length;
+		m_mass = b2SoftMass(m_invMassA + m_invMassB, length - m_length, m_stiffness, m_damping, h, &m_gamma, &m_bias);
+	}
+	else
+	{
+		m_u.SetZero();
+		m_mass = 0.0f;
+		m_impulse = 0.0f;
+	}
+
+	// Angular part
+	m_gradA.SetZero();
+	m_gradB.SetZero();
+	m_gradC.SetZero();
+	m_angularMass = 0.0f;
+	if (m_bodyC)
+	{
+		m_indexC = m_bodyC->m_islandIndex;
+		m_invMassC = m_bodyC->m_invMass;
+
+		b2Vec2 cC = data.positions[m_indexC].c;
+		b2Vec2 p = cA - cC;
+		b2Vec2 q = cA - cB;
+		float32 pp = b2Dot(p, p);
+		float32 qq = b2Dot(q, q);
+		if (pp > b2_linearSlop * b2_linearSlop && qq > b2_linearSlop * b2_linearSlop && m_angularStiffness > 0.0f)
+		{
+			m_gradC = (1.0f / pp) * b2Cross(1.0f, p);
+			m_gradB = (-1.0f / qq) * b2Cross(1.0f, q);
+			m_gradA = -m_gradB - m_gradC;
+
+			float32 invMass = m_invMassA * b2Dot(m_gradA, m_gradA) + m_invMassB * b2Dot(m_gradB, m_gradB) + m_invMassC * b2Dot(m_gradC, m_gradC);
+			float32 C = b2CornerAngle(p, q) - m_angle;
+			m_angularMass = b2SoftMass(invMass, C, m_angularStiffness, m_angularDamping, h, &m_angularGamma, &m_angularBias);
+		}
+	}
+	if (m_angularMass == 0.0f)
+	{
+		m_angularImpulse = 0.0f;
+	}
+
+	if (data.step.warmStarting)
+	{
+		// Scale the impulses to support a variable time step.
+		m_impulse *= data.step.dtRatio;
+		m_angularImpulse *= data.step.dtRatio;
+
+		b2Vec2 P = m_impulse * m_u;
+		vA += m_invMassA * (m_angularImpulse * m_gradA - P);
+		vB += m_invMassB * (m_angularImpulse * m_gradB + P);
+		if (m_bodyC)
+		{
+			data.velocities[m_indexC].v += (m_invMassC * m_angularImpulse) * m_gradC;
+		}
+	}
+	else
+	{
+		m_impulse = 0.0f;
+		m_angularImpulse = 0.0f;
+	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexB].v = vB;
+}
+
+void b2SpringJoint::SolveVelocityConstraints(const b2SolverData& data)
+{
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+
+	// Linear part
+	if (m_mass > 0.0f)
+	{
+		float32 Cdot = b2Dot(m_u, vB - vA);
+		float32 impulse = -m_mass * (Cdot + m_bias + m_gamma * m_impulse);
+		m_impulse += impulse;
+
+		b2Vec2 P = impulse * m_u;
+		vA -= m_invMassA * P;
+		vB += m_invMassB * P;
+	}
+
+	// Angular part
+	if (m_angularMass > 0.0f)
+	{
+		b2Vec2 vC = data.velocities[m_indexC].v;
+
+		float32 Cdot = b2Dot(m_gradA, vA) + b2Dot(m_gradB, vB) + b2Dot(m_gradC, vC);
+		float32 impulse = -m_angularMass * (Cdot + m_angularBias + m_angularGamma * m_angularImpulse);
+		m_angularImpulse += impulse;
+
+		vA += (m_invMassA * impulse) * m_gradA;
+		vB += (m_invMassB * impulse) * m_gradB;
+		vC += (m_invMassC * impulse) * m_gradC;
+
+		data.velocities[m_indexC].v = vC;
+	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexB].v = vB;
+}
+
+bool b2SpringJoint::SolvePositionConstraints(const b2SolverData& data)
+{
+	B2_NOT_USED(data);
+
+	// There is no position correction for soft constraints.
+	return true;
+}
+
+b2Vec2 b2SpringJoint::GetAnchorA() const
+{
+	return m_bodyA->GetWorldCenter();
+}
+
+b2Vec2 b2SpringJoint::GetAnchorB() const
+{
+	return m_bodyB->GetWorldCenter();
+}
+
+b2Vec2 b2SpringJoint::GetReactionForce(float32 inv_dt) const
+{
+	b2Vec2 F = (inv_dt * m_impulse) * m_u;
+	return F;
+}
+
+float32 b2SpringJoint::GetReactionTorque(float32 inv_dt) const
+{
+	return inv_dt * m_angularImpulse;
+}
+
+void b2SpringJoint::Dump()
+{
+	int32 indexA = m_bodyA->m_islandIndex;
+	int32 indexB = m_bodyB->m_islandIndex;
+
+	b2Log("  b2SpringJointDef jd;\n");
+	b2Log("  jd.bodyA = bodies[%d];\n", indexA);
+	b2Log("  jd.bodyB = bodies[%d];\n", indexB);
+	if (m_bodyC)
+	{
+		b2Log("  jd.bodyC = bodies[%d];\n", m_bodyC->m_islandIndex);
+	}
+	b2Log("  jd.collideConnected = bool(%d);\n", m_collideConnected);
+	b2Log("  jd.length = %.15lef;\n", m_length);
+	b2Log("  jd.stiffness = %.15lef;\n", m_stiffness);
+	b2Log("  jd.damping = %.15lef;\n", m_damping);
+	b2Log("  jd.angle = %.15lef;\n", m_angle);
+	b2Log("  jd.angularStiffness = %.15lef;\n", m_angularStiffness);
+	b2Log("  jd.angularDamping = %.15lef;\n", m_angularDamping);
+	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
+}
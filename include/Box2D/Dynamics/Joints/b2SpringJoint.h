@@ -0,0 +1,207 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SPRING_JOINT_H
+#define B2_SPRING_JOINT_H
+
+#include "Box2D/Dynamics/Joints/b2Joint.h"
+
+/// Spring joint definition. The spring acts on the centers of mass
+/// of the bodies. The linear part pulls bodyA and bodyB towards the
+/// rest length. The optional angular part bends the corner at bodyA,
+/// between bodyC and bodyB, towards the rest angle.
+/// @warning bodyC must be connected to bodyA or bodyB by another joint
+/// (e.g. the previous spring of a chain) so it is solved in the same island.
+struct b2SpringJointDef : public b2JointDef
+{
+	b2SpringJointDef()
+	{
+		type = e_springJoint;
+		bodyC = nullptr;
+		length = 1.0f;
+		stiffness = 0.0f;
+		damping = 0.0f;
+		angle = b2_pi;
+		angularStiffness = 0.0f;
+		angularDamping = 0.0f;
+	}
+
+	/// Initialize the bodies, rest length and rest angle using the
+	/// current positions. bodyC may be nullptr for no angular part.
+	void Initialize(b2Body* bodyC, b2Body* bodyA, b2Body* bodyB);
+
+	/// The previous body of the corner, or nullptr for no angular part.
+	b2Body* bodyC;
+
+	/// The rest length between bodyA and bodyB.
+	float32 length;
+
+	/// The linear stiffness in N/m. 0 disables the linear part.
+	float32 stiffness;
+
+	/// The linear damping in N*s/m.
+	float32 damping;
+
+	/// The rest angle at bodyA, measured counter-clockwise from (bodyA - bodyC)
+	/// to (bodyA - bodyB), in [0, 2 * pi). A straight corner is pi.
+	float32 angle;
+
+	/// The angular stiffness in N*m/radian. 0 disables the angular part.
+	float32 angularStiffness;
+
+	/// The angular damping in N*m*s/radian.
+	float32 angularDamping;
+};
+
+/// A spring joint is a stiff spring between two bodies that can also bend
+/// at a third. Unlike applying spring forces before each step, it is solved
+/// implicitly with the other constraints and warm started, so it stays
+/// stable with high stiffness and long time steps.
+class b2SpringJoint : public b2Joint
+{
+public:
+
+	b2Vec2 GetAnchorA() const override;
+	b2Vec2 GetAnchorB() const override;
+
+	/// Get the linear reaction force on bodyB given the inverse time step.
+	/// Unit is N.
+	b2Vec2 GetReactionForce(float32 inv_dt) const override;
+
+	/// Get the angular reaction given the inverse time step.
+	/// Unit is N*m.
+	float32 GetReactionTorque(float32 inv_dt) const override;
+
+	/// Get the previous body of the corner, nullptr if there is no angular part.
+	b2Body* GetBodyC() { return m_bodyC; }
+
+	/// Set/get the rest length.
+	void SetLength(float32 length);
+	float32 GetLength() const;
+
+	/// Set/get the rest angle in radians.
+	void SetAngle(float32 angle);
+	float32 GetAngle() const;
+
+	/// Set/get the linear stiffness and damping.
+	void SetStiffness(float32 stiffness, float32 damping);
+	float32 GetStiffness() const;
+	float32 GetDamping() const;
+
+	/// Set/get the angular stiffness and damping.
+	void SetAngularStiffness(float32 stiffness, float32 damping);
+	float32 GetAngularStiffness() const;
+	float32 GetAngularDamping() const;
+
+	/// Dump joint to dmLog
+	void Dump() override;
+
+protected:
+
+	friend class b2Joint;
+	b2SpringJoint(const b2SpringJointDef* data);
+
+	void InitVelocityConstraints(const b2SolverData& data) override;
+	void SolveVelocityConstraints(const b2SolverData& data) override;
+	bool SolvePositionConstraints(const b2SolverData& data) override;
+
+	b2Body* m_bodyC;
+
+	float32 m_length;
+	float32 m_stiffness;
+	float32 m_damping;
+	float32 m_angle;
+	float32 m_angularStiffness;
+	float32 m_angularDamping;
+
+	// Solver shared
+	float32 m_impulse;
+	float32 m_angularImpulse;
+
+	// Solver temp
+	int32 m_indexA;
+	int32 m_indexB;
+	int32 m_indexC;
+	float32 m_invMassA;
+	float32 m_invMassB;
+	float32 m_invMassC;
+	b2Vec2 m_u;
+	float32 m_gamma;
+	float32 m_bias;
+	float32 m_mass;
+	b2Vec2 m_gradA;
+	b2Vec2 m_gradB;
+	b2Vec2 m_gradC;
+	float32 m_angularGamma;
+	float32 m_angularBias;
+	float32 m_angularMass;
+};
+
+inline void b2SpringJoint::SetLength(float32 length)
+{
+	m_length = length;
+}
+
+inline float32 b2SpringJoint::GetLength() const
+{
+	return m_length;
+}
+
+inline void b2SpringJoint::SetAngle(float32 angle)
+{
+	m_angle = angle;
+}
+
+inline float32 b2SpringJoint::GetAngle() const
+{
+	return m_angle;
+}
+
+inline void b2SpringJoint::SetStiffness(float32 stiffness, float32 damping)
+{
+	m_stiffness = stiffness;
+	m_damping = damping;
+}
+
+inline float32 b2SpringJoint::GetStiffness() const
+{
+	return m_stiffness;
+}
+
+inline float32 b2SpringJoint::GetDamping() const
+{
+	return m_damping;
+}
+
+inline void b2SpringJoint::SetAngularStiffness(float32 stiffness, float32 damping)
+{
+	m_angularStiffness = stiffness;
+	m_angularDamping = damping;
+}
+
+inline float32 b2SpringJoint::GetAngularStiffness() const
+{
+	return m_angularStiffness;
+}
+
+inline float32 b2SpringJoint::GetAngularDamping() const
+{
+	return m_angularDamping;
+}
+
+#endif
@@ -103,6 +103,11 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_fixtureList = nullptr;
 	m_fixtureCount = 0;
+
+	if (m_type == b2_dynamicBody && bd->massData.mass > 0.0f)
+	{
+		ApplyMassData(&bd->massData);
+	}
 }
 
 b2Body::~b2Body()
@@ -171,13 +176,18 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return nullptr;
 	}
 
+	return AddFixture(def, true);
+}
+
+b2Fixture* b2Body::AddFixture(const b2FixtureDef* def, bool createProxies)
+{
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
 	b2Fixture* fixture = new (memory) b2Fixture;
 	fixture->Create(allocator, this, def);
 
-	if (m_flags & e_activeFlag)
+	if (createProxies && (m_flags & e_activeFlag))
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		fixture->CreateProxies(broadPhase, m_xf);
@@ -368,6 +378,11 @@ void b2Body::SetMassData(const b2MassData* massData)
 		return;
 	}
 
+	ApplyMassData(massData);
+}
+
+void b2Body::ApplyMassData(const b2MassData* massData)
+{
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
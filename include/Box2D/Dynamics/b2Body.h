@@ -67,6 +67,9 @@ struct b2BodyDef
 		type = b2_staticBody;
 		active = true;
 		gravityScale = 1.0f;
+		massData.mass = 0.0f;
+		massData.center.SetZero();
+		massData.I = 0.0f;
 	}
 
 	/// The body type: static, kinematic, or dynamic.
@@ -122,6 +125,12 @@ struct b2BodyDef
 
 	/// Scale the gravity applied to this body.
 	float32 gravityScale;
+
+	/// Mass properties of a dynamic body that has no fixtures. Such a body has no
+	/// broad-phase proxy and never collides, it is only moved by forces and joints.
+	/// A mass of zero keeps the default of one. Adding a fixture (or anything else
+	/// that calls ResetMassData) replaces this with the mass of the fixtures.
+	b2MassData massData;
 };
 
 /// A rigid body. These are created via b2World::CreateBody.
@@ -406,6 +415,7 @@ private:
 	friend class b2PulleyJoint;
 	friend class b2RevoluteJoint;
 	friend class b2RopeJoint;
+	friend class b2SpringJoint;
 	friend class b2WeldJoint;
 	friend class b2WheelJoint;
 
@@ -424,6 +434,12 @@ private:
 	b2Body(const b2BodyDef* bd, b2World* world);
 	~b2Body();
 
+	// SetMassData without the checks, for the constructor.
+	void ApplyMassData(const b2MassData* massData);
+
+	// CreateFixture, but the caller adds the fixture's proxies to the broad-phase if createProxies is false.
+	b2Fixture* AddFixture(const b2FixtureDef* def, bool createProxies);
+
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
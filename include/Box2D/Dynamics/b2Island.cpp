@@ -27,6 +27,8 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Timer.h"
 
+#include <string.h>
+
 /*
 Position Correction Notes
 =========================
@@ -257,14 +259,50 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	// Solve velocity constraints
 	timer.Reset();
-	for (int32 i = 0; i < step.velocityIterations; ++i)
+	b2Velocity* previous = nullptr;
+	float32 toleranceSquared = step.velocityTolerance * step.velocityTolerance;
+	if (step.velocityTolerance > 0.0f)
 	{
+		previous = (b2Velocity*)m_allocator->Allocate(m_bodyCount * sizeof(b2Velocity));
+	}
+
+	int32 velocityIterations = 0;
+	while (velocityIterations < step.velocityIterations)
+	{
+		if (previous)
+		{
+			memcpy(previous, m_velocities, m_bodyCount * sizeof(b2Velocity));
+		}
+
 		for (int32 j = 0; j < m_jointCount; ++j)
 		{
 			m_joints[j]->SolveVelocityConstraints(solverData);
 		}
 
 		contactSolver.SolveVelocityConstraints();
+		++velocityIterations;
+
+		if (previous)
+		{
+			// Exit early once an iteration barely changes any velocity.
+			bool converged = true;
+			for (int32 i = 0; i < m_bodyCount && converged; ++i)
+			{
+				b2Vec2 dv = m_velocities[i].v - previous[i].v;
+				float32 dw = m_velocities[i].w - previous[i].w;
+				converged = b2Dot(dv, dv) <= toleranceSquared && dw * dw <= toleranceSquared;
+			}
+
+			if (converged)
+			{
+				break;
+			}
+		}
+	}
+
+	if (previous)
+	{
+		m_allocator->Free(previous);
 	}
 
 	// Store impulses for warm starting
@@ -307,8 +345,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	// Solve position constraints
 	timer.Reset();
 	bool positionSolved = false;
+	int32 positionIterations = 0;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
+		++positionIterations;
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
 
 		bool jointsOkay = true;
@@ -338,6 +378,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
+	profile->islandCount = 1;
+	profile->velocityIterations = velocityIterations;
+	profile->maxVelocityIterations = velocityIterations;
+	profile->positionIterations = positionIterations;
+	profile->maxPositionIterations = positionIterations;
 
 	Report(contactSolver.m_velocityConstraints);
 
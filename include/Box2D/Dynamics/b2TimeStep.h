@@ -32,6 +32,14 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+
+	/// Solver iterations actually run, not counting TOI.
+	/// Totals are summed over islands, max is the most any one island ran.
+	int32 islandCount;
+	int32 velocityIterations;
+	int32 maxVelocityIterations;
+	int32 positionIterations;
+	int32 maxPositionIterations;
 };
 
 /// This is an internal structure.
@@ -42,6 +50,7 @@ struct b2TimeStep
 	float32 dtRatio;	// dt * inv_dt0
 	int32 velocityIterations;
 	int32 positionIterations;
+	float32 velocityTolerance;	// see b2World::SetVelocityTolerance
 	bool warmStarting;
 };
 
@@ -39,6 +39,11 @@ b2World::b2World(const b2Vec2& gravity)
 	m_destructionListener = nullptr;
 	m_debugDraw = nullptr;
 
+	m_taskExecutor = nullptr;
+	m_taskStackAllocators = nullptr;
+	m_taskProfiles = nullptr;
+	m_taskThreadCount = 0;
+
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
 
@@ -48,6 +53,7 @@ b2World::b2World(const b2Vec2& gravity)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_velocityTolerance = 0.0f;
 
 	m_stepComplete = true;
 
@@ -82,6 +88,8 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetTaskExecutor(nullptr);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -104,6 +112,40 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_taskThreadCount; ++i)
+	{
+		m_taskStackAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_taskStackAllocators);
+	b2Free(m_taskProfiles);
+	m_taskStackAllocators = nullptr;
+	m_taskProfiles = nullptr;
+	m_taskThreadCount = 0;
+
+	m_taskExecutor = executor;
+	if (executor == nullptr)
+	{
+		return;
+	}
+
+	// Each thread solves its islands out of its own stack allocator.
+	m_taskThreadCount = b2Max(executor->GetThreadCount(), 1);
+	m_taskStackAllocators = (b2StackAllocator*)b2Alloc(m_taskThreadCount * sizeof(b2StackAllocator));
+	m_taskProfiles = (b2Profile*)b2Alloc(m_taskThreadCount * sizeof(b2Profile));
+	for (int32 i = 0; i < m_taskThreadCount; ++i)
+	{
+		new (m_taskStackAllocators + i) b2StackAllocator;
+	}
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -128,6 +170,113 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	return b;
 }
 
+// Size of the memory a shape of the given type is cloned into.
+static int32 b2GetShapeSize(b2Shape::Type type)
+{
+	switch (type)
+	{
+	case b2Shape::e_circle:
+		return sizeof(b2CircleShape);
+	case b2Shape::e_edge:
+		return sizeof(b2EdgeShape);
+	case b2Shape::e_polygon:
+		return sizeof(b2PolygonShape);
+	case b2Shape::e_chain:
+		return sizeof(b2ChainShape);
+	default:
+		return 0;
+	}
+}
+
+void b2World::CreateBodies(const b2BodyDef* defs, int32 count, const b2FixtureDef* fixtureDef, b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	int32 childCount = fixtureDef ? fixtureDef->shape->GetChildCount() : 0;
+
+	m_blockAllocator.Reserve(sizeof(b2Body), count);
+	if (fixtureDef)
+	{
+		m_blockAllocator.Reserve(sizeof(b2Fixture), count);
+		m_blockAllocator.Reserve(childCount * sizeof(b2FixtureProxy), count);
+		m_blockAllocator.Reserve(b2GetShapeSize(fixtureDef->shape->GetType()), count);
+	}
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		bodies[i] = CreateBody(defs + i);
+		if (fixtureDef)
+		{
+			bodies[i]->AddFixture(fixtureDef, false);
+			if (bodies[i]->m_flags & b2Body::e_activeFlag)
+			{
+				proxyCount += childCount;
+			}
+		}
+	}
+
+	if (proxyCount == 0)
+	{
+		return;
+	}
+
+	// Add every proxy to the broad-phase at once.
+	b2AABB* aabbs = (b2AABB*)b2Alloc(proxyCount * sizeof(b2AABB));
+	void** userData = (void**)b2Alloc(proxyCount * sizeof(void*));
+	int32* proxyIds = (int32*)b2Alloc(proxyCount * sizeof(int32));
+
+	int32 proxyIndex = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		if ((b->m_flags & b2Body::e_activeFlag) == 0)
+		{
+			continue;
+		}
+
+		b2Fixture* fixture = b->m_fixtureList;
+		fixture->m_proxyCount = childCount;
+		for (int32 j = 0; j < childCount; ++j)
+		{
+			b2FixtureProxy* proxy = fixture->m_proxies + j;
+			fixture->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, j);
+			proxy->fixture = fixture;
+			proxy->childIndex = j;
+			aabbs[proxyIndex] = proxy->aabb;
+			userData[proxyIndex] = proxy;
+			++proxyIndex;
+		}
+	}
+
+	m_contactManager.m_broadPhase.CreateProxies(aabbs, userData, proxyCount, proxyIds);
+
+	proxyIndex = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		if ((b->m_flags & b2Body::e_activeFlag) == 0)
+		{
+			continue;
+		}
+
+		b2Fixture* fixture = b->m_fixtureList;
+		for (int32 j = 0; j < childCount; ++j)
+		{
+			fixture->m_proxies[j].proxyId = proxyIds[proxyIndex];
+			++proxyIndex;
+		}
+	}
+
+	b2Free(proxyIds);
+	b2Free(userData);
+	b2Free(aabbs);
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -269,6 +418,11 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	return j;
 }
 
+void b2World::ReserveJoints(const b2JointDef* def, int32 count)
+{
+	m_blockAllocator.Reserve(b2Joint::GetSize(def->type), count);
+}
+
 void b2World::DestroyJoint(b2Joint* j)
 {
 	b2Assert(IsLocked() == false);
@@ -382,12 +536,83 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
+// An island that was found by the DFS but not solved yet. It indexes the
+// flat body, contact and joint arrays built up during b2World::Solve.
+struct b2PendingIsland
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+};
+
+// Adds the solver times and iteration counts of one island (or one thread's islands) to total.
+static void b2AddSolverProfile(b2Profile* total, const b2Profile& profile)
+{
+	total->solveInit += profile.solveInit;
+	total->solveVelocity += profile.solveVelocity;
+	total->solvePosition += profile.solvePosition;
+	total->islandCount += profile.islandCount;
+	total->velocityIterations += profile.velocityIterations;
+	total->maxVelocityIterations = b2Max(total->maxVelocityIterations, profile.maxVelocityIterations);
+	total->positionIterations += profile.positionIterations;
+	total->maxPositionIterations = b2Max(total->maxPositionIterations, profile.maxPositionIterations);
+}
+
+// Solves runs of pending islands, one run per task index. Pending islands
+// never contain static bodies, so no body is shared between two of them.
+class b2IslandSolveTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex) override
+	{
+		b2StackAllocator* allocator = world->m_taskStackAllocators + threadIndex;
+		b2Profile* threadProfile = world->m_taskProfiles + threadIndex;
+
+		for (int32 i = runStarts[index]; i < runStarts[index + 1]; ++i)
+		{
+			const b2PendingIsland& pending = islands[i];
+			b2Island island(pending.bodyCount, pending.contactCount, pending.jointCount,
+							allocator, world->m_contactManager.m_contactListener);
+
+			for (int32 j = 0; j < pending.bodyCount; ++j)
+			{
+				island.Add(bodies[pending.bodyStart + j]);
+			}
+			for (int32 j = 0; j < pending.contactCount; ++j)
+			{
+				island.Add(contacts[pending.contactStart + j]);
+			}
+			for (int32 j = 0; j < pending.jointCount; ++j)
+			{
+				island.Add(joints[pending.jointStart + j]);
+			}
+
+			b2Profile profile;
+			island.Solve(&profile, *step, world->m_gravity, world->m_allowSleep);
+			b2AddSolverProfile(threadProfile, profile);
+		}
+	}
+
+	b2World* world;
+	const b2TimeStep* step;
+	const b2PendingIsland* islands;
+	const int32* runStarts;
+	b2Body* const* bodies;
+	b2Contact* const* contacts;
+	b2Joint* const* joints;
+};
+
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.islandCount = 0;
+	m_profile.velocityIterations = 0;
+	m_profile.maxVelocityIterations = 0;
+	m_profile.positionIterations = 0;
+	m_profile.maxPositionIterations = 0;
 
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
@@ -413,6 +638,26 @@ void b2World::Solve(const b2TimeStep& step)
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+
+	// With a task executor, islands without static bodies are only collected here
+	// and solved in parallel afterwards. Islands touching a static body are still
+	// solved right away because the static body's island index is shared.
+	bool deferIslands = m_taskExecutor != nullptr && m_taskThreadCount > 1;
+	b2PendingIsland* pendingIslands = nullptr;
+	b2Body** pendingBodies = nullptr;
+	b2Contact** pendingContacts = nullptr;
+	b2Joint** pendingJoints = nullptr;
+	int32 pendingIslandCount = 0;
+	int32 pendingBodyCount = 0;
+	int32 pendingContactCount = 0;
+	int32 pendingJointCount = 0;
+	if (deferIslands)
+	{
+		pendingIslands = (b2PendingIsland*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2PendingIsland));
+		pendingBodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+		pendingContacts = (b2Contact**)m_stackAllocator.Allocate(m_contactManager.m_contactCount * sizeof(b2Contact*));
+		pendingJoints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	}
 	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
 	{
 		if (seed->m_flags & b2Body::e_islandFlag)
@@ -527,11 +772,47 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
+		if (deferIslands)
+		{
+			bool hasStatic = false;
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				if (island.m_bodies[i]->GetType() == b2_staticBody)
+				{
+					hasStatic = true;
+					break;
+				}
+			}
+
+			if (hasStatic == false)
+			{
+				b2PendingIsland* pending = pendingIslands + pendingIslandCount++;
+				pending->bodyStart = pendingBodyCount;
+				pending->bodyCount = island.m_bodyCount;
+				pending->contactStart = pendingContactCount;
+				pending->contactCount = island.m_contactCount;
+				pending->jointStart = pendingJointCount;
+				pending->jointCount = island.m_jointCount;
+
+				for (int32 i = 0; i < island.m_bodyCount; ++i)
+				{
+					pendingBodies[pendingBodyCount++] = island.m_bodies[i];
+				}
+				for (int32 i = 0; i < island.m_contactCount; ++i)
+				{
+					pendingContacts[pendingContactCount++] = island.m_contacts[i];
+				}
+				for (int32 i = 0; i < island.m_jointCount; ++i)
+				{
+					pendingJoints[pendingJointCount++] = island.m_joints[i];
+				}
+				continue;
+			}
+		}
+
 		b2Profile profile;
 		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		b2AddSolverProfile(&m_profile, profile);
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -545,6 +826,16 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 	}
 
+	if (deferIslands)
+	{
+		SolvePendingIslands(step, pendingIslands, pendingIslandCount, pendingBodies, pendingContacts, pendingJoints);
+
+		m_stackAllocator.Free(pendingJoints);
+		m_stackAllocator.Free(pendingContacts);
+		m_stackAllocator.Free(pendingBodies);
+		m_stackAllocator.Free(pendingIslands);
+	}
+
 	m_stackAllocator.Free(stack);
 
 	{
@@ -563,6 +854,12 @@ void b2World::Solve(const b2TimeStep& step)
 				continue;
 			}
 
+			// Bodies without fixtures have nothing in the broad-phase.
+			if (b->m_fixtureList == nullptr)
+			{
+				continue;
+			}
+
 			// Update fixtures (for broad-phase).
 			b->SynchronizeFixtures();
 		}
@@ -573,6 +870,71 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 }
 
+// Split the pending islands into runs of similar size and hand them to the task executor.
+void b2World::SolvePendingIslands(const b2TimeStep& step, const b2PendingIsland* islands, int32 islandCount,
+								  b2Body* const* bodies, b2Contact* const* contacts, b2Joint* const* joints)
+{
+	if (islandCount == 0)
+	{
+		return;
+	}
+
+	// A few runs per thread so uneven islands still balance.
+	int32 totalWork = 0;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		totalWork += islands[i].bodyCount + islands[i].contactCount + islands[i].jointCount;
+	}
+	int32 maxRunCount = b2Min(islandCount, 4 * m_taskThreadCount);
+	int32 runWork = b2Max(totalWork / maxRunCount, 1);
+
+	int32* runStarts = (int32*)m_stackAllocator.Allocate((islandCount + 1) * sizeof(int32));
+	int32 runCount = 0;
+	int32 work = 0;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		if (work == 0)
+		{
+			runStarts[runCount++] = i;
+		}
+
+		work += islands[i].bodyCount + islands[i].contactCount + islands[i].jointCount;
+		if (work >= runWork)
+		{
+			work = 0;
+		}
+	}
+	runStarts[runCount] = islandCount;
+
+	memset(m_taskProfiles, 0, m_taskThreadCount * sizeof(b2Profile));
+
+	b2IslandSolveTask task;
+	task.world = this;
+	task.step = &step;
+	task.islands = islands;
+	task.runStarts = runStarts;
+	task.bodies = bodies;
+	task.contacts = contacts;
+	task.joints = joints;
+
+	if (runCount == 1)
+	{
+		task.Execute(0, 0);
+	}
+	else
+	{
+		m_taskExecutor->ParallelFor(&task, runCount);
+	}
+
+	// Solver times are summed over all threads.
+	for (int32 i = 0; i < m_taskThreadCount; ++i)
+	{
+		b2AddSolverProfile(&m_profile, m_taskProfiles[i]);
+	}
+
+	m_stackAllocator.Free(runStarts);
+}
+
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
@@ -859,6 +1221,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.dtRatio = 1.0f;
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
+		subStep.velocityTolerance = 0.0f;
 		subStep.warmStarting = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
@@ -911,6 +1274,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dt = dt;
 	step.velocityIterations	= velocityIterations;
 	step.positionIterations = positionIterations;
+	step.velocityTolerance = m_velocityTolerance;
 	if (dt > 0.0f)
 	{
 		step.inv_dt = 1.0f / dt;
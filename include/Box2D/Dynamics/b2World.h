@@ -29,11 +29,13 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+struct b2PendingIsland;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -61,6 +63,12 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Register a task executor used to solve independent islands on several threads.
+	/// The executor is owned by you and must remain in scope. Pass nullptr to solve
+	/// every island on the calling thread.
+	/// @warning with an executor b2ContactListener::PostSolve may be called from the executor's threads.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -71,6 +79,13 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create count rigid bodies, each with its own fixture made from fixtureDef (none if it is nullptr).
+	/// The same as calling CreateBody and CreateFixture count times, but memory is reserved up front and
+	/// the broad-phase tree is built once for all the new proxies instead of one insert at a time.
+	/// @param bodies receives the new bodies, in the same order as defs.
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* defs, int32 count, const b2FixtureDef* fixtureDef, b2Body** bodies);
+
 	/// Destroy a rigid body given a definition. No reference to the definition
 	/// is retained. This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -82,6 +97,10 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2Joint* CreateJoint(const b2JointDef* def);
 
+	/// Reserve memory for count more joints of the same type as def, so creating
+	/// many joints doesn't add memory one chunk at a time.
+	void ReserveJoints(const b2JointDef* def, int32 count);
+
 	/// Destroy a joint. This may cause the connected bodies to begin colliding.
 	/// @warning This function is locked during callbacks.
 	void DestroyJoint(b2Joint* joint);
@@ -157,6 +176,12 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Stop an island's velocity iterations early once an iteration changes no
+	/// body's linear (m/s) or angular (rad/s) velocity by more than this.
+	/// 0 (the default) always runs every iteration. See b2Profile for how many ran.
+	void SetVelocityTolerance(float32 tolerance) { m_velocityTolerance = tolerance; }
+	float32 GetVelocityTolerance() const { return m_velocityTolerance; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -223,8 +248,11 @@ private:
 	friend class b2Fixture;
 	friend class b2ContactManager;
 	friend class b2Controller;
+	friend class b2IslandSolveTask;
 
 	void Solve(const b2TimeStep& step);
+	void SolvePendingIslands(const b2TimeStep& step, const b2PendingIsland* islands, int32 islandCount,
+							 b2Body* const* bodies, b2Contact* const* contacts, b2Joint* const* joints);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawJoint(b2Joint* joint);
@@ -249,6 +277,13 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
 
+	// Islands are solved in parallel through this when it is set. Each executor
+	// thread gets its own stack allocator and profile.
+	b2TaskExecutor* m_taskExecutor;
+	b2StackAllocator* m_taskStackAllocators;
+	b2Profile* m_taskProfiles;
+	int32 m_taskThreadCount;
+
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
@@ -258,6 +293,8 @@ private:
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
+	float32 m_velocityTolerance;
+
 	bool m_stepComplete;
 
 	b2Profile m_profile;
@@ -152,4 +152,33 @@ public:
 									const b2Vec2& normal, float32 fraction) = 0;
 };
 
+/// A unit of work for a b2TaskExecutor.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Run one item of the task.
+	/// @param index the item, in [0, count) of the ParallelFor call
+	/// @param threadIndex the thread running the item, in [0, b2TaskExecutor::GetThreadCount())
+	virtual void Execute(int32 index, int32 threadIndex) = 0;
+};
+
+/// Implement this class to let the world spread independent work (currently
+/// island solving) across several threads.
+/// See b2World::SetTaskExecutor
+class b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// The number of threads that may run items at the same time. This must not
+	/// change while the executor is registered with a world.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Call task->Execute for every index in [0, count), in any order and on
+	/// any of the executor's threads, and return once all of them have finished.
+	virtual void ParallelFor(b2Task* task, int32 count) = 0;
+};
+
 #endif
@@ -0,0 +1,302 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Rope/b2SpringNetwork.h"
+#include "Box2D/Common/b2Draw.h"
+
+#include <string.h>
+
+// XPBD, each constraint C with compliance alpha and gradients gi:
+// alphaTilde = alpha / h^2
+// dLambda = (-C - alphaTilde * lambda) / (sum(invMass_i * |gi|^2) + alphaTilde)
+// p_i += invMass_i * gi * dLambda
+// lambda starts at 0 every step.
+
+// Bend at b between a and c
+// p = b - a, q = b - c
+// C = atan2(cross(p, q), dot(p, q)) - angle, wrapped to [-pi, pi]
+// ga = perp(p) / |p|^2, gc = -perp(q) / |q|^2, gb = -ga - gc
+
+// Copies count elements to a new array of capacity elements.
+static void* b2GrowArray(void* array, int32 count, int32 capacity, int32 elementSize)
+{
+	void* grown = b2Alloc(capacity * elementSize);
+	if (count > 0)
+	{
+		memcpy(grown, array, count * elementSize);
+	}
+	b2Free(array);
+	return grown;
+}
+
+b2SpringNetwork::b2SpringNetwork()
+{
+	m_count = 0;
+	m_capacity = 0;
+	m_ps = nullptr;
+	m_p0s = nullptr;
+	m_vs = nullptr;
+	m_ims = nullptr;
+
+	m_distanceCount = 0;
+	m_distanceCapacity = 0;
+	m_distances = nullptr;
+	m_distanceLambdas = nullptr;
+
+	m_bendCount = 0;
+	m_bendCapacity = 0;
+	m_bends = nullptr;
+	m_bendLambdas = nullptr;
+
+	m_gravity.SetZero();
+	m_damping = 0.0f;
+}
+
+b2SpringNetwork::~b2SpringNetwork()
+{
+	b2Free(m_ps);
+	b2Free(m_p0s);
+	b2Free(m_vs);
+	b2Free(m_ims);
+	b2Free(m_distances);
+	b2Free(m_distanceLambdas);
+	b2Free(m_bends);
+	b2Free(m_bendLambdas);
+}
+
+void b2SpringNetwork::Initialize(const b2SpringNetworkDef* def)
+{
+	m_gravity = def->gravity;
+	m_damping = def->damping;
+}
+
+void b2SpringNetwork::Reserve(int32 nodeCount, int32 distanceCount, int32 bendCount)
+{
+	if (m_count + nodeCount > m_capacity)
+	{
+		m_capacity = m_count + nodeCount;
+		m_ps = (b2Vec2*)b2GrowArray(m_ps, m_count, m_capacity, sizeof(b2Vec2));
+		m_p0s = (b2Vec2*)b2GrowArray(m_p0s, m_count, m_capacity, sizeof(b2Vec2));
+		m_vs = (b2Vec2*)b2GrowArray(m_vs, m_count, m_capacity, sizeof(b2Vec2));
+		m_ims = (float32*)b2GrowArray(m_ims, m_count, m_capacity, sizeof(float32));
+	}
+
+	if (m_distanceCount + distanceCount > m_distanceCapacity)
+	{
+		m_distanceCapacity = m_distanceCount + distanceCount;
+		m_distances = (b2DistanceConstraint*)b2GrowArray(m_distances, m_distanceCount, m_distanceCapacity, sizeof(b2DistanceConstraint));
+		m_distanceLambdas = (float32*)b2GrowArray(m_distanceLambdas, m_distanceCount, m_distanceCapacity, sizeof(float32));
+	}
+
+	if (m_bendCount + bendCount > m_bendCapacity)
+	{
+		m_bendCapacity = m_bendCount + bendCount;
+		m_bends = (b2BendConstraint*)b2GrowArray(m_bends, m_bendCount, m_bendCapacity, sizeof(b2BendConstraint));
+		m_bendLambdas = (float32*)b2GrowArray(m_bendLambdas, m_bendCount, m_bendCapacity, sizeof(float32));
+	}
+}
+
+int32 b2SpringNetwork::AddNode(const b2Vec2& position, float32 mass)
+{
+	if (m_count == m_capacity)
+	{
+		Reserve(b2Max(m_capacity, 16), 0, 0);
+	}
+
+	int32 index = m_count++;
+	m_ps[index] = position;
+	m_p0s[index] = position;
+	m_vs[index].SetZero();
+	m_ims[index] = mass > 0.0f ? 1.0f / mass : 0.0f;
+	return index;
+}
+
+void b2SpringNetwork::AddDistance(int32 a, int32 b, float32 length, float32 compliance)
+{
+	b2Assert(0 <= a && a < m_count && 0 <= b && b < m_count);
+	if (m_distanceCount == m_distanceCapacity)
+	{
+		Reserve(0, b2Max(m_distanceCapacity, 16), 0);
+	}
+
+	b2DistanceConstraint* distance = m_distances + m_distanceCount++;
+	distance->a = a;
+	distance->b = b;
+	distance->length = length;
+	distance->compliance = compliance;
+}
+
+void b2SpringNetwork::AddBend(int32 a, int32 b, int32 c, float32 angle, float32 compliance)
+{
+	b2Assert(0 <= a && a < m_count && 0 <= b && b < m_count && 0 <= c && c < m_count);
+	if (m_bendCount == m_bendCapacity)
+	{
+		Reserve(0, 0, b2Max(m_bendCapacity, 16));
+	}
+
+	b2BendConstraint* bend = m_bends + m_bendCount++;
+	bend->a = a;
+	bend->b = b;
+	bend->c = c;
+	bend->angle = angle;
+	bend->compliance = compliance;
+}
+
+void b2SpringNetwork::Step(float32 h, int32 iterations)
+{
+	if (h == 0.0f)
+	{
+		return;
+	}
+
+	// Same damping as b2Island::Solve applies to bodies
+	float32 d = 1.0f / (1.0f + h * m_damping);
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_p0s[i] = m_ps[i];
+		if (m_ims[i] > 0.0f)
+		{
+			m_vs[i] += h * m_gravity;
+			m_vs[i] *= d;
+			m_ps[i] += h * m_vs[i];
+		}
+	}
+
+	if (m_distanceCount > 0)
+	{
+		memset(m_distanceLambdas, 0, m_distanceCount * sizeof(float32));
+	}
+	if (m_bendCount > 0)
+	{
+		memset(m_bendLambdas, 0, m_bendCount * sizeof(float32));
+	}
+
+	float32 inv_h2 = 1.0f / (h * h);
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		SolveDistances(inv_h2);
+		SolveBends(inv_h2);
+	}
+
+	float32 inv_h = 1.0f / h;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_vs[i] = inv_h * (m_ps[i] - m_p0s[i]);
+	}
+}
+
+void b2SpringNetwork::SolveDistances(float32 inv_h2)
+{
+	for (int32 i = 0; i < m_distanceCount; ++i)
+	{
+		const b2DistanceConstraint& distance = m_distances[i];
+
+		float32 im1 = m_ims[distance.a];
+		float32 im2 = m_ims[distance.b];
+		if (im1 + im2 == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 p1 = m_ps[distance.a];
+		b2Vec2 p2 = m_ps[distance.b];
+
+		b2Vec2 n = p2 - p1;
+		float32 L = n.Normalize();
+		if (L == 0.0f)
+		{
+			continue;
+		}
+
+		float32 C = L - distance.length;
+		float32 alpha = distance.compliance * inv_h2;
+		float32 lambda = m_distanceLambdas[i];
+		float32 dLambda = (-C - alpha * lambda) / (im1 + im2 + alpha);
+		m_distanceLambdas[i] = lambda + dLambda;
+
+		m_ps[distance.a] = p1 - (im1 * dLambda) * n;
+		m_ps[distance.b] = p2 + (im2 * dLambda) * n;
+	}
+}
+
+void b2SpringNetwork::SolveBends(float32 inv_h2)
+{
+	for (int32 i = 0; i < m_bendCount; ++i)
+	{
+		const b2BendConstraint& bend = m_bends[i];
+
+		float32 m1 = m_ims[bend.a];
+		float32 m2 = m_ims[bend.b];
+		float32 m3 = m_ims[bend.c];
+
+		b2Vec2 p1 = m_ps[bend.a];
+		b2Vec2 p2 = m_ps[bend.b];
+		b2Vec2 p3 = m_ps[bend.c];
+
+		b2Vec2 p = p2 - p1;
+		b2Vec2 q = p2 - p3;
+
+		float32 Lpsqr = p.LengthSquared();
+		float32 Lqsqr = q.LengthSquared();
+
+		if (Lpsqr * Lqsqr == 0.0f)
+		{
+			continue;
+		}
+
+		b2Vec2 J1 = (1.0f / Lpsqr) * b2Cross(1.0f, p);
+		b2Vec2 J3 = (-1.0f / Lqsqr) * b2Cross(1.0f, q);
+		b2Vec2 J2 = -J1 - J3;
+
+		float32 mass = m1 * b2Dot(J1, J1) + m2 * b2Dot(J2, J2) + m3 * b2Dot(J3, J3);
+		if (mass == 0.0f)
+		{
+			continue;
+		}
+
+		float32 C = b2Atan2(b2Cross(p, q), b2Dot(p, q)) - bend.angle;
+		while (C > b2_pi)
+		{
+			C -= 2.0f * b2_pi;
+		}
+		while (C < -b2_pi)
+		{
+			C += 2.0f * b2_pi;
+		}
+
+		float32 alpha = bend.compliance * inv_h2;
+		float32 lambda = m_bendLambdas[i];
+		float32 dLambda = (-C - alpha * lambda) / (mass + alpha);
+		m_bendLambdas[i] = lambda + dLambda;
+
+		m_ps[bend.a] = p1 + (m1 * dLambda) * J1;
+		m_ps[bend.b] = p2 + (m2 * dLambda) * J2;
+		m_ps[bend.c] = p3 + (m3 * dLambda) * J3;
+	}
+}
+
+void b2SpringNetwork::Draw(b2Draw* draw) const
+{
+	b2Color c(0.4f, 0.5f, 0.7f);
+
+	for (int32 i = 0; i < m_distanceCount; ++i)
+	{
+		draw->DrawSegment(m_ps[m_distances[i].a], m_ps[m_distances[i].b], c);
+	}
+}
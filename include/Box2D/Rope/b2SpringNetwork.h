@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SPRING_NETWORK_H
+#define B2_SPRING_NETWORK_H
+
+#include "Box2D/Common/b2Math.h"
+
+class b2Draw;
+
+///
+struct b2SpringNetworkDef
+{
+	b2SpringNetworkDef()
+	{
+		gravity.SetZero();
+		damping = 0.0f;
+	}
+
+	///
+	b2Vec2 gravity;
+
+	/// Linear damping of every node, like b2BodyDef::linearDamping.
+	float32 damping;
+};
+
+/// A graph of point masses held together by extended position based (XPBD)
+/// constraints. Like b2Rope, but any node can have any number of constraints:
+/// distance constraints between two nodes and bending constraints at the
+/// corner of three. Nodes where several lines meet are shared by them, so they
+/// stay pinned together without joints. A node is a fraction of the size of a
+/// b2Body and compliant constraints converge in tens of iterations.
+/// Compliance is inverse stiffness, 0 makes a constraint rigid.
+class b2SpringNetwork
+{
+public:
+	b2SpringNetwork();
+	~b2SpringNetwork();
+
+	///
+	void Initialize(const b2SpringNetworkDef* def);
+
+	/// Grow the arrays once for this many more nodes and constraints.
+	void Reserve(int32 nodeCount, int32 distanceCount, int32 bendCount);
+
+	/// Add a node and return its index. A mass of 0 pins the node in place.
+	int32 AddNode(const b2Vec2& position, float32 mass);
+
+	/// Keep nodes a and b length apart. Compliance is in m/N.
+	void AddDistance(int32 a, int32 b, float32 length, float32 compliance);
+
+	/// Bend the corner at node b towards angle, measured counter-clockwise
+	/// from (b - a) to (b - c). A straight corner is pi. Compliance is in radians/(N*m).
+	void AddBend(int32 a, int32 b, int32 c, float32 angle, float32 compliance);
+
+	///
+	void Step(float32 timeStep, int32 iterations);
+
+	///
+	int32 GetNodeCount() const
+	{
+		return m_count;
+	}
+
+	///
+	const b2Vec2* GetPositions() const
+	{
+		return m_ps;
+	}
+
+	///
+	const b2Vec2* GetVelocities() const
+	{
+		return m_vs;
+	}
+
+	/// 0 for pinned nodes.
+	float32 GetMass(int32 index) const
+	{
+		return m_ims[index] > 0.0f ? 1.0f / m_ims[index] : 0.0f;
+	}
+
+	///
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	struct b2DistanceConstraint
+	{
+		int32 a, b;
+		float32 length;
+		float32 compliance;
+	};
+
+	struct b2BendConstraint
+	{
+		int32 a, b, c;
+		float32 angle;
+		float32 compliance;
+	};
+
+	void SolveDistances(float32 inv_h2);
+	void SolveBends(float32 inv_h2);
+
+	int32 m_count;
+	int32 m_capacity;
+	b2Vec2* m_ps;
+	b2Vec2* m_p0s;
+	b2Vec2* m_vs;
+	float32* m_ims;
+
+	int32 m_distanceCount;
+	int32 m_distanceCapacity;
+	b2DistanceConstraint* m_distances;
+	float32* m_distanceLambdas;
+
+	int32 m_bendCount;
+	int32 m_bendCapacity;
+	b2BendConstraint* m_bends;
+	float32* m_bendLambdas;
+
+	b2Vec2 m_gravity;
+	float32 m_damping;
+};
+
+#endif